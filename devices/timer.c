@@ -3,10 +3,12 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,30 +19,142 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, and the count for one timer tick:
+   PIT_HZ divided by TIMER_FREQ, rounded to nearest. */
+#define PIT_HZ 1193180
+#define TICK_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Most ticks that one one-shot count of the 16-bit counter can
+   cover. */
+#define TICKLESS_MAX (0xffff / TICK_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* Tickless idle.
+
+   While the idle thread halts, there is nothing to do at a tick
+   unless a timeout expires or the timer wheel cascades.
+   timer_idle_enter() then switches counter 0 to a one-shot count
+   that ends at the next such tick, and timer_idle_exit(), called
+   on the next interrupt, runs the ticks that were skipped.
+
+   tickless_count is the one-shot count as programmed, of which
+   the first tickless_first counts finish the tick that was
+   running and every TICK_COUNT after that make one more tick.
+   tickless_ticks is the number of ticks the count covers. */
+static bool tickless;
+static unsigned tickless_count;
+static unsigned tickless_first;
+static int64_t tickless_ticks;
+static int64_t skipped_ticks;  /* # of ticks run without an interrupt. */
+
+/* Sub-tick sleeps.
+
+   real_time_sleep() sleeps on the timer wheel for whole ticks and
+   in hr_list for the rest, which is less than a tick.  When the
+   earliest deadline in hr_list falls before the end of the
+   current tick, hr_arm() switches counter 0 to a one-shot count
+   that ends at the deadline, and hr_rest keeps the counts from
+   there to the end of the tick.  That interrupt is not a tick:
+   timer_interrupt() wakes the sleepers and finishes the tick with
+   another one-shot count, as timer_idle_exit() does.  A deadline
+   in a later tick is armed by that tick.
+
+   Only the BSP receives the interrupt, but any CPU may arm it. */
+struct hr_sleeper
+{
+	struct list_elem elem;	/* Element in hr_list. */
+	int64_t deadline;		/* timer_ns() to wake up at. */
+	struct thread *thread;	/* Sleeping thread. */
+};
+
+static struct list hr_list;	/* Ordered by deadline. */
+static bool hr_armed;		/* Counter 0 ends at a sub-tick deadline. */
+static unsigned hr_rest;	/* Counts from then to the end of the tick. */
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Nanoseconds per timer tick. */
+#define NS_PER_TICK (NSEC_PER_SEC / TIMER_FREQ)
+
+/* Clock source for timer_ns(), the time stamp counter (TSC).
+
+   timer_calibrate() measures the TSC frequency against the PIT.
+   From then on, timer_ns() is tsc_base_ns plus the cycles since
+   tsc_base, converted with tsc_mult, which is nanoseconds per
+   cycle as a 32.32 fixed-point number.  Until then, timer_ns()
+   only has tick resolution. */
+#define TSC_CALIBRATE_TICKS DIV_ROUND_UP(TIMER_FREQ, 20)
+static uint64_t tsc_hz;
+static uint64_t tsc_mult;
+static uint64_t tsc_base;
+static int64_t tsc_base_ns;
+
+/* Hierarchical timer wheel of pending timeouts.
+
+   There are WHEEL_LEVELS levels of WHEEL_SIZE slots each.  A slot
+   of level 0 holds the timeouts of one tick; a slot of level L
+   covers WHEEL_SIZE^L ticks.  A timeout goes into the lowest level
+   whose range covers its distance from wheel_clock, so adding (and
+   cancelling) one is O(1).  Whenever level L-1 wraps around, the
+   current slot of level L is cascaded: its timeouts are added
+   again and so move down a level.  A timeout is cascaded at most
+   WHEEL_LEVELS - 1 times, which makes expiry amortized O(1).
+
+   Timeouts further away than WHEEL_RANGE ticks wait in the top
+   level and are re-added whenever they are cascaded.
+
+   The wheel is protected by disabling interrupts. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1LL << (WHEEL_BITS * WHEEL_LEVELS))
+
+static struct list wheel[WHEEL_LEVELS][WHEEL_SIZE];
+
+/* Next tick to process.  Every timeout that expires before it
+   has already run. */
+static int64_t wheel_clock;
+
+/* 타이머 인터럽트 핸들러 지연 시간 (TSC 사이클) */
+static uint64_t tick_cycles_total;
+static uint64_t tick_cycles_max;
+
 static intr_handler_func timer_interrupt;
 static bool too_many_loops(unsigned loops);
 static void busy_wait(int64_t loops);
+static void tsc_calibrate(void);
 static void real_time_sleep(int64_t num, int32_t denom);
+static void wheel_insert(struct timeout *);
+static void wheel_advance(int64_t now);
+static int64_t wheel_next_event(int64_t limit);
+static timeout_func wake_up;
+static void pit_periodic(void);
+static void pit_oneshot(unsigned count);
+static void timer_tick(void);
+static void hr_sleep(int64_t deadline);
+static void hr_arm(void);
+static bool hr_program(unsigned end, unsigned limit);
+static void hr_expire(void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void timer_init(void)
 {
-	/* 8254 input frequency divided by TIMER_FREQ, rounded to
-	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	int level, slot;
 
-	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb(0x40, count & 0xff);
-	outb(0x40, count >> 8);
+	for (level = 0; level < WHEEL_LEVELS; level++)
+		for (slot = 0; slot < WHEEL_SIZE; slot++)
+			list_init(&wheel[level][slot]);
+	wheel_clock = ticks + 1;
+	list_init(&hr_list);
+
+	pit_periodic();
 
 	intr_register_ext(0x20, timer_interrupt, "8254 Timer");
 }
@@ -69,6 +183,9 @@ void timer_calibrate(void)
 			loops_per_tick |= test_bit;
 
 	printf("%'" PRIu64 " loops/s.\n", (uint64_t)loops_per_tick * TIMER_FREQ);
+
+	tsc_calibrate();
+	printf("TSC: %'" PRIu64 " Hz.\n", tsc_hz);
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -90,13 +207,45 @@ timer_elapsed(int64_t then)
 	return timer_ticks() - then;
 }
 
+/* Returns the number of nanoseconds since the OS booted.  Has
+   the resolution of the TSC once timer_calibrate() has run, and
+   of the timer tick before. */
+int64_t
+timer_ns(void)
+{
+	uint64_t delta;
+
+	if (tsc_hz == 0)
+		return timer_ticks() * NS_PER_TICK;
+
+	/* 64비트 곱셈이 넘치지 않도록 상위 32비트와 하위 32비트를 따로 곱한다. */
+	delta = rdtsc() - tsc_base;
+	return tsc_base_ns + (int64_t)((delta >> 32) * tsc_mult + (((delta & 0xffffffff) * tsc_mult) >> 32));
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 void timer_sleep(int64_t ticks)
 {
 	int64_t start = timer_ticks();
+	struct timeout to;
+	enum intr_level old_level;
 
 	ASSERT(intr_get_level() == INTR_ON);
-	thread_sleep(start + ticks);
+	if (ticks <= 0)
+		return;
+
+	old_level = intr_disable();
+	timeout_init(&to, wake_up, thread_current());
+	timeout_add(&to, start + ticks);
+	thread_block();
+	intr_set_level(old_level);
+}
+
+/* timer_sleep()으로 잠든 쓰레드 T를 깨운다. */
+static void
+wake_up(void *t)
+{
+	thread_unblock(t);
 }
 
 /* Suspends execution for approximately MS milliseconds. */
@@ -120,12 +269,278 @@ void timer_nsleep(int64_t ns)
 /* Prints timer statistics. */
 void timer_print_stats(void)
 {
-	printf("Timer: %" PRId64 " ticks\n", timer_ticks());
+	int64_t t = timer_ticks();
+
+	printf("Timer: %" PRId64 " ticks\n", t);
+	printf("Timer: %" PRId64 " ticks skipped while idle\n", skipped_ticks);
+	if (t > 0)
+		printf("Timer interrupt: %" PRIu64 " cycles avg, %" PRIu64 " cycles max\n",
+			   tick_cycles_total / t, tick_cycles_max);
+}
+
+/* Called by the idle thread, with interrupts off, right before
+   it halts.  If no timeout expires at the next tick, stops the
+   periodic timer interrupt until the next tick that has work to
+   do, at most TICKLESS_MAX ticks away.
+
+   Only the BSP receives the timer interrupt, so this does
+   nothing on other CPUs.  Neither does it while the APs run
+   threads, since they add timeouts without waking the BSP, nor
+   while the one-shot count that timer_idle_exit() left behind
+   still runs to the end of the current tick, nor while a
+   sub-tick sleep is pending. */
+void timer_idle_enter(void)
+{
+	int64_t next;
+	unsigned left;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (cpu_current() != &cpus[0] || cpu_online_cnt > 1 || tickless)
+		return;
+	if (hr_armed || !list_empty(&hr_list))
+		return;
+	ASSERT(wheel_clock == ticks + 1);
+
+	next = wheel_next_event(ticks + TICKLESS_MAX);
+	if (next - ticks <= 1)
+		return;
+
+	/* 지금 돌고 있는 틱의 남은 카운트.  주기 모드에서는 TICK_COUNT부터 1까지 센다. */
+	outb(0x43, 0x00); /* CW: latch counter 0. */
+	left = inb(0x40);
+	left |= inb(0x40) << 8;
+	if (left == 0 || left > TICK_COUNT)
+		left = TICK_COUNT;
+
+	tickless = true;
+	tickless_first = left;
+	tickless_ticks = next - ticks;
+	tickless_count = left + (tickless_ticks - 1) * TICK_COUNT;
+	pit_oneshot(tickless_count);
+}
+
+/* Called on every external interrupt, before its handler.  If
+   the timer is in the one-shot mode of timer_idle_enter(), runs
+   the ticks that have passed since then, so the handler sees an
+   up-to-date timer_ticks(), and goes back to periodic
+   interrupts. */
+void timer_idle_exit(void)
+{
+	unsigned status, left, done;
+	int64_t passed;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!tickless)
+		return;
+
+	outb(0x43, 0xc2); /* CW: read back status and count of counter 0. */
+	status = inb(0x40);
+	left = inb(0x40);
+	left |= inb(0x40) << 8;
+
+	if (status & 0x80)
+	{
+		/* 카운트가 끝났다 (OUT 핀이 올라감).  마지막 틱은 대기 중인
+		   타이머 인터럽트가 처리한다. */
+		tickless = false;
+		passed = tickless_ticks - 1;
+		pit_periodic();
+	}
+	else
+	{
+		/* 다른 인터럽트로 깨어났다.  지나간 틱만 처리하고, 지금 틱이
+		   끝나는 시각에 한 번 더 인터럽트를 받아 주기 모드로 돌아간다. */
+		done = tickless_count - left;
+		passed = done < tickless_first ? 0 : 1 + (done - tickless_first) / TICK_COUNT;
+		tickless_first += passed * TICK_COUNT - done;
+		tickless_count = tickless_first;
+		tickless_ticks = 1;
+		pit_oneshot(tickless_count);
+	}
+
+	skipped_ticks += passed;
+	while (passed-- > 0)
+		timer_tick();
+}
+
+/* Initializes timeout TO to call FUNC with AUX when it expires. */
+void timeout_init(struct timeout *to, timeout_func *func, void *aux)
+{
+	ASSERT(to != NULL);
+	ASSERT(func != NULL);
+
+	to->func = func;
+	to->aux = aux;
+	to->pending = false;
+}
+
+/* Arms TO to expire at timer tick EXPIRES.  If EXPIRES has already
+   passed, TO expires at the next timer interrupt.  TO must not be
+   pending.  May be called from an interrupt handler. */
+void timeout_add(struct timeout *to, int64_t expires)
+{
+	enum intr_level old_level;
+
+	ASSERT(to != NULL);
+	ASSERT(!to->pending);
+
+	old_level = intr_disable();
+	to->expires = expires;
+	to->pending = true;
+	wheel_insert(to);
+	intr_set_level(old_level);
+}
+
+/* Disarms TO.  Returns true if it was pending, false if it has
+   already expired (or was never armed).  May be called from an
+   interrupt handler. */
+bool timeout_cancel(struct timeout *to)
+{
+	enum intr_level old_level;
+	bool pending;
+
+	ASSERT(to != NULL);
+
+	old_level = intr_disable();
+	pending = to->pending;
+	if (pending)
+	{
+		list_remove(&to->elem);
+		to->pending = false;
+	}
+	intr_set_level(old_level);
+	return pending;
+}
+
+/* TO를 만료 시각에 맞는 바퀴 칸에 넣는다.  인터럽트를 끄고 호출. */
+static void
+wheel_insert(struct timeout *to)
+{
+	int64_t expires = to->expires;
+	int64_t delta;
+	int level;
+
+	/* 이미 지났으면 다음에 처리할 틱에, 너무 멀면 맨 위 단계의
+	   마지막 칸에 둔다.  후자는 cascade 때 다시 자리를 찾는다. */
+	if (expires < wheel_clock)
+		expires = wheel_clock;
+	else if (expires - wheel_clock >= WHEEL_RANGE)
+		expires = wheel_clock + WHEEL_RANGE - 1;
+
+	delta = expires - wheel_clock;
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < 1LL << (WHEEL_BITS * (level + 1)))
+			break;
+	list_push_back(&wheel[level][(expires >> (WHEEL_BITS * level)) & WHEEL_MASK], &to->elem);
+}
+
+/* NOW까지의 틱을 처리하며 만료된 timeout을 실행한다.  인터럽트를 끄고 호출. */
+static void
+wheel_advance(int64_t now)
+{
+	while (wheel_clock <= now)
+	{
+		struct list *slot = &wheel[0][wheel_clock & WHEEL_MASK];
+		int level;
+
+		/* 아래 단계가 한 바퀴 돌았으면 위 단계의 현재 칸을 내려보낸다. */
+		for (level = 1; level < WHEEL_LEVELS; level++)
+		{
+			int shift = WHEEL_BITS * level;
+			struct list *upper;
+
+			if ((wheel_clock & ((1LL << shift) - 1)) != 0)
+				break;
+			upper = &wheel[level][(wheel_clock >> shift) & WHEEL_MASK];
+			while (!list_empty(upper))
+				wheel_insert(list_entry(list_pop_front(upper), struct timeout, elem));
+		}
+
+		while (!list_empty(slot))
+		{
+			struct timeout *to = list_entry(list_pop_front(slot), struct timeout, elem);
+			to->pending = false;
+			to->func(to->aux);
+		}
+		wheel_clock++;
+	}
+}
+
+/* Returns the first tick after the current one, up to LIMIT, at
+   which a timeout expires or the wheel cascades.  Ticks before it
+   have nothing to process.  인터럽트를 끄고 호출. */
+static int64_t
+wheel_next_event(int64_t limit)
+{
+	int64_t t;
+
+	/* 올라오는 timeout은 cascade 때만 0단계로 내려오므로 0단계만 보면 된다. */
+	for (t = wheel_clock; t < limit; t++)
+		if ((t & WHEEL_MASK) == 0 || !list_empty(&wheel[0][t & WHEEL_MASK]))
+			return t;
+	return limit;
+}
+
+/* Makes counter 0 interrupt every TICK_COUNT counts. */
+static void
+pit_periodic(void)
+{
+	outb(0x43, 0x34); /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb(0x40, TICK_COUNT & 0xff);
+	outb(0x40, TICK_COUNT >> 8);
+}
+
+/* Makes counter 0 interrupt once, COUNT counts from now. */
+static void
+pit_oneshot(unsigned count)
+{
+	ASSERT(count > 0 && count <= 0xffff);
+
+	outb(0x43, 0x30); /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb(0x40, count & 0xff);
+	outb(0x40, count >> 8);
 }
 
 /* Timer interrupt handler. */
 static void
 timer_interrupt(struct intr_frame *args UNUSED)
+{
+	uint64_t start = rdtsc();
+	uint64_t cycles;
+
+	if (hr_armed)
+	{
+		/* 틱 중간의 마감에 맞춘 one-shot이 끝났다.  틱이 아니므로 잠든
+		   쓰레드만 깨우고, 틱의 나머지를 다시 one-shot으로 센다. */
+		hr_armed = false;
+		hr_expire();
+		if (!hr_program(hr_rest, hr_rest))
+		{
+			tickless = true;
+			tickless_first = tickless_count = hr_rest;
+			tickless_ticks = 1;
+			pit_oneshot(tickless_count);
+		}
+		return;
+	}
+
+	timer_tick();
+	hr_expire();
+	hr_arm();
+
+	cycles = rdtsc() - start;
+	tick_cycles_total += cycles;
+	if (cycles > tick_cycles_max)
+		tick_cycles_max = cycles;
+}
+
+/* Runs one timer tick: the scheduler, the MLFQS bookkeeping and
+   the timeouts that expire.  Called by the timer interrupt and by
+   timer_idle_exit() for the ticks that were skipped. */
+static void
+timer_tick(void)
 {
 	ticks++;
 	thread_tick();
@@ -143,8 +558,47 @@ timer_interrupt(struct intr_frame *args UNUSED)
 
 	}
 
-	/*타이머 인터럽트 발생 시 쓰레드 sleep_list 확인*/
-	thread_wake(timer_ticks());
+	/* 만료된 timeout 실행 (잠든 쓰레드 깨우기 등) */
+	wheel_advance(ticks);
+}
+
+/* Runs a timer tick on an AP, from its local APIC timer.  The
+   BSP keeps the time and runs the timeouts, so this only charges
+   the thread that the AP is running. */
+void timer_tick_ap(void)
+{
+	thread_tick();
+	if (thread_mlfqs)
+	{
+		thread_recent_cpu_incr();
+		if (timer_ticks() % 4 == 0)
+			thread_calc_priority();
+	}
+}
+
+/* Measures the TSC frequency over TSC_CALIBRATE_TICKS timer
+   ticks, counted from one tick edge to another. */
+static void
+tsc_calibrate(void)
+{
+	int64_t start;
+	uint64_t t0, t1;
+
+	ASSERT(intr_get_level() == INTR_ON);
+
+	start = ticks;
+	while (ticks == start)
+		barrier();
+	t0 = rdtsc();
+	start = ticks;
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier();
+	t1 = rdtsc();
+
+	tsc_hz = (t1 - t0) * TIMER_FREQ / TSC_CALIBRATE_TICKS;
+	tsc_mult = ((uint64_t)NSEC_PER_SEC << 32) / tsc_hz;
+	tsc_base = t1;
+	tsc_base_ns = (start + TSC_CALIBRATE_TICKS) * NS_PER_TICK;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -180,32 +634,139 @@ busy_wait(int64_t loops)
 		barrier();
 }
 
-/* Sleep for approximately NUM/DENOM seconds. */
+/* Sleep for approximately NUM/DENOM seconds.
+
+   Sleeps on the timer wheel for the whole ticks that remain, which
+   never overshoots the deadline, and then in hr_list until the
+   deadline itself, so that short waits are not rounded up to a
+   tick. */
 static void
 real_time_sleep(int64_t num, int32_t denom)
 {
-	/* Convert NUM/DENOM seconds into timer ticks, rounding down.
-
-     (NUM / DENOM) s
-     ---------------------- = NUM * TIMER_FREQ / DENOM ticks.
-     1 s / TIMER_FREQ ticks
-     */
-  int64_t ticks = num * TIMER_FREQ / denom;
+	int64_t deadline, left;
 
 	ASSERT(intr_get_level() == INTR_ON);
-	if (ticks > 0)
+	ASSERT(NSEC_PER_SEC % denom == 0);
+
+	if (tsc_hz == 0)
+	{
+		/* timer_calibrate() 전에는 예전처럼 틱 단위로 자거나 루프를 돈다. */
+		int64_t ticks = num * TIMER_FREQ / denom;
+		if (ticks > 0)
+			timer_sleep(ticks);
+		else
+			busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		return;
+	}
+
+	deadline = timer_ns() + num * (NSEC_PER_SEC / denom);
+	while ((left = deadline - timer_ns()) > 0)
 	{
-		/* We're waiting for at least one full timer tick.  Use
-		   timer_sleep() because it will yield the CPU to other
-		   processes. */
-		timer_sleep(ticks);
+		/* 남은 시간보다 일찍 깨도록 틱 단위로 내린다.  1틱 미만이
+		   남으면 마감에 맞춘 one-shot 인터럽트를 기다린다. */
+		if (left >= NS_PER_TICK)
+			timer_sleep(left / NS_PER_TICK);
+		else
+			hr_sleep(deadline);
+	}
+}
+
+/* Blocks the running thread until timer_ns() reaches DEADLINE,
+   which must be less than a tick away. */
+static void
+hr_sleep(int64_t deadline)
+{
+	struct hr_sleeper s;
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	old_level = intr_disable();
+	s.deadline = deadline;
+	s.thread = thread_current();
+	for (e = list_begin(&hr_list); e != list_end(&hr_list); e = list_next(e))
+		if (list_entry(e, struct hr_sleeper, elem)->deadline > deadline)
+			break;
+	list_insert(e, &s.elem);
+	hr_arm();
+	thread_block();
+	intr_set_level(old_level);
+}
+
+/* Arms counter 0 for the earliest deadline in hr_list if it
+   falls before the end of the current tick and before the
+   one-shot count that may already run for an earlier one. */
+static void
+hr_arm(void)
+{
+	unsigned status, left, end;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (list_empty(&hr_list))
+		return;
+
+	outb(0x43, 0xc2); /* CW: read back status and count of counter 0. */
+	status = inb(0x40);
+	left = inb(0x40);
+	left |= inb(0x40) << 8;
+
+	if (hr_armed || tickless)
+	{
+		/* one-shot 카운트.  이미 끝났거나 아직 장전 전이면 곧 올
+		   인터럽트가 다시 부른다.  여기서 보는 tickless는 지금 틱의
+		   끝까지만 센다 (자고 있지 않은 CPU만 마감을 더하므로). */
+		ASSERT(!tickless || tickless_ticks == 1);
+		if (status & 0xc0)
+			return;
+		end = hr_armed ? left + hr_rest : left;
+		hr_program(end, left);
 	}
 	else
 	{
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
-		ASSERT(denom % 1000 == 0);
-		busy_wait(loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		/* 주기 모드는 TICK_COUNT부터 1까지 센다. */
+		if ((status & 0x40) || left == 0 || left > TICK_COUNT)
+			left = TICK_COUNT;
+		hr_program(left, left);
+	}
+}
+
+/* If the earliest deadline in hr_list is less than LIMIT counts
+   away, makes counter 0 interrupt at it, END counts before the
+   end of the current tick, and returns true. */
+static bool
+hr_program(unsigned end, unsigned limit)
+{
+	int64_t ns;
+	unsigned count;
+
+	if (list_empty(&hr_list))
+		return false;
+
+	ns = list_entry(list_front(&hr_list), struct hr_sleeper, elem)->deadline - timer_ns();
+	count = ns <= 0 ? 1 : DIV_ROUND_UP(ns * PIT_HZ, NSEC_PER_SEC);
+	if (count >= limit)
+		return false;
+
+	hr_armed = true;
+	hr_rest = end - count;
+	tickless = false;
+	pit_oneshot(count);
+	return true;
+}
+
+/* Wakes the threads in hr_list whose deadline has passed. */
+static void
+hr_expire(void)
+{
+	int64_t now = timer_ns();
+
+	while (!list_empty(&hr_list))
+	{
+		struct hr_sleeper *s = list_entry(list_front(&hr_list), struct hr_sleeper, elem);
+
+		if (s->deadline > now)
+			break;
+		list_pop_front(&hr_list);
+		thread_unblock(s->thread);
 	}
 }
@@ -1,17 +1,23 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <list.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* Nanoseconds per second. */
+#define NSEC_PER_SEC 1000000000LL
+
 void timer_init(void);
 void timer_calibrate(void);
 
 int64_t timer_ticks(void);
 int64_t timer_elapsed(int64_t);
+int64_t timer_ns(void);
 
 void timer_sleep(int64_t ticks);
 void timer_msleep(int64_t milliseconds);
@@ -20,4 +26,25 @@ void timer_nsleep(int64_t nanoseconds);
 
 void timer_print_stats(void);
 
+void timer_idle_enter(void);
+void timer_idle_exit(void);
+void timer_tick_ap(void);
+
+/* A one-shot callback at a given timer tick.  FUNC runs in the
+   timer interrupt, with interrupts off, so it must not sleep. */
+typedef void timeout_func(void *aux);
+
+struct timeout
+{
+	struct list_elem elem; /* Element in a timer wheel slot. */
+	int64_t expires;	   /* Tick at which FUNC is called. */
+	timeout_func *func;	   /* Function to call. */
+	void *aux;			   /* Argument for FUNC. */
+	bool pending;		   /* Armed and not yet expired or cancelled. */
+};
+
+void timeout_init(struct timeout *, timeout_func *, void *aux);
+void timeout_add(struct timeout *, int64_t expires);
+bool timeout_cancel(struct timeout *);
+
 #endif /* devices/timer.h */
@@ -43,6 +43,46 @@ static __inline uint64_t read_eflags(void) {
 	return rflags;
 }
 
+__attribute__((always_inline))
+static __inline uint64_t rcr0(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr0,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr0(uint64_t val) {
+	__asm __volatile("movq %0,%%cr0" : : "r" (val) : "memory");
+}
+
+__attribute__((always_inline))
+static __inline uint64_t rcr4(void) {
+	uint64_t val;
+	__asm __volatile("movq %%cr4,%0" : "=r" (val));
+	return val;
+}
+
+__attribute__((always_inline))
+static __inline void lcr4(uint64_t val) {
+	__asm __volatile("movq %0,%%cr4" : : "r" (val) : "memory");
+}
+
+/* Clears CR0.TS.  See [IA32-v2a] "CLTS". */
+__attribute__((always_inline))
+static __inline void clts(void) {
+	__asm __volatile("clts" : : : "memory");
+}
+
+/* Executes CPUID with EAX = LEAF and ECX = SUBLEAF.
+   See [IA32-v2a] "CPUID". */
+__attribute__((always_inline))
+static __inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t *eax,
+		uint32_t *ebx, uint32_t *ecx, uint32_t *edx) {
+	__asm __volatile("cpuid"
+			: "=a" (*eax), "=b" (*ebx), "=c" (*ecx), "=d" (*edx)
+			: "a" (leaf), "c" (subleaf));
+}
+
 __attribute__((always_inline))
 static __inline uint64_t rcr3(void) {
 	uint64_t val;
@@ -128,4 +168,38 @@ static __inline void write_msr(uint32_t ecx, uint64_t val) {
 			:: "c" (ecx), "d" (edx), "a" (eax) );
 }
 
+/* Reads the time-stamp counter.  See [IA32-v2b] "RDTSC". */
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t edx, eax;
+	__asm __volatile("rdtsc" : "=d" (edx), "=a" (eax));
+	return ((uint64_t) edx << 32) | eax;
+}
+
+/* Atomically stores VAL into *ADDR and returns the old value.
+   XCHG with a memory operand is implicitly locked and is also a
+   full memory barrier.  See [IA32-v2b] "XCHG". */
+__attribute__((always_inline))
+static __inline uint32_t xchg(volatile uint32_t *addr, uint32_t val) {
+	__asm __volatile("xchgl %0, %1"
+			: "+m" (*addr), "+r" (val) : : "memory");
+	return val;
+}
+
+/* Atomically compares *ADDR with OLD and, if they are equal,
+   stores NEW into it.  Returns the value that *ADDR had, which
+   equals OLD on success.  See [IA32-v2a] "CMPXCHG". */
+__attribute__((always_inline))
+static __inline uint64_t cmpxchg(volatile uint64_t *addr, uint64_t old, uint64_t new) {
+	__asm __volatile("lock cmpxchgq %2, %1"
+			: "+a" (old), "+m" (*addr) : "r" (new) : "memory", "cc");
+	return old;
+}
+
+/* Spin-wait hint.  See [IA32-v2b] "PAUSE". */
+__attribute__((always_inline))
+static __inline void cpu_relax(void) {
+	__asm __volatile("pause" : : : "memory");
+}
+
 #endif /* intrinsic.h */
@@ -36,6 +36,16 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Futexes. */
+	SYS_FUTEX_WAIT,             /* Sleep while a user int has a value. */
+	SYS_FUTEX_WAKE,             /* Wake threads sleeping on a user int. */
+
+	/* User threads. */
+	SYS_THREAD_CREATE,          /* Start a thread in this process. */
+	SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+	SYS_THREAD_EXIT,            /* Exit the current thread. */
+	SYS_THREAD_STATS,           /* Read a thread's CPU statistics. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,41 @@
+#ifndef __LIB_USER_PTHREAD_H
+#define __LIB_USER_PTHREAD_H
+
+#include <debug.h>
+#include <syscall.h>
+
+/* A small subset of POSIX threads on top of the thread_create,
+   thread_join and futex system calls.  Functions that return int
+   return 0 on success and -1 on failure. */
+
+typedef tid_t pthread_t;
+
+/* Mutex: 0 = unlocked, 1 = locked, 2 = locked with waiters. */
+typedef struct {
+	int state;
+} pthread_mutex_t;
+
+#define PTHREAD_MUTEX_INITIALIZER { 0 }
+
+/* Condition variable: a sequence number bumped on every signal. */
+typedef struct {
+	int seq;
+} pthread_cond_t;
+
+#define PTHREAD_COND_INITIALIZER { 0 }
+
+int pthread_create (pthread_t *, void *(*start) (void *), void *arg);
+int pthread_join (pthread_t, void **retval);
+void pthread_exit (void *retval) NO_RETURN;
+
+int pthread_mutex_init (pthread_mutex_t *);
+int pthread_mutex_lock (pthread_mutex_t *);
+int pthread_mutex_trylock (pthread_mutex_t *);
+int pthread_mutex_unlock (pthread_mutex_t *);
+
+int pthread_cond_init (pthread_cond_t *);
+int pthread_cond_wait (pthread_cond_t *, pthread_mutex_t *);
+int pthread_cond_signal (pthread_cond_t *);
+int pthread_cond_broadcast (pthread_cond_t *);
+
+#endif /* lib/user/pthread.h */
@@ -9,6 +9,10 @@
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Thread identifier. */
+typedef int tid_t;
+#define TID_ERROR ((tid_t) -1)
+
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *) NULL)
@@ -50,6 +54,29 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Futexes. */
+int futex_wait (int *addr, int expected, int timeout_ms);
+int futex_wake (int *addr, int n);
+
+/* User threads.  See pthread.h for the library built on these. */
+tid_t thread_create (void (*entry) (void *fn, void *arg), void *fn, void *arg);
+int thread_join (tid_t tid, void **retval);
+void thread_exit (void *retval) NO_RETURN;
+
+/* CPU and scheduling statistics of a thread, in nanoseconds. */
+struct thread_stats {
+	long long run_ns;           /* Time spent running. */
+	long long ready_ns;         /* Time spent waiting to run. */
+	long long ready_max_ns;     /* Longest single wait to run. */
+	long long lock_ns;          /* Time spent asleep on locks. */
+	unsigned long long dispatches;  /* Times given the CPU. */
+	unsigned long long voluntary;   /* Times it slept or exited. */
+	unsigned long long involuntary; /* Times it was preempted. */
+};
+
+/* Statistics of thread TID, or of the caller if TID is 0. */
+bool thread_stats (tid_t tid, struct thread_stats *);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,59 @@
+#ifndef THREADS_CPU_H
+#define THREADS_CPU_H
+
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Maximum number of CPUs supported. */
+#define CPU_MAX 8
+
+/* Per-CPU state.
+
+   cpus[0] is the bootstrap processor (BSP), the one that ran the
+   loader and init.c:main().  The others are application
+   processors (APs), found through the BIOS MP tables and started
+   by cpu_start_aps().
+
+   A CPU runs threads once it is online.  cpu0 is online from
+   the start and every AP from the end of its bring-up.
+
+   The run queue is owned by thread.c.  It is protected by
+   rq_lock, since other CPUs may push threads onto it or steal
+   threads from it.  Deadline threads with budget left wait in
+   dl_list, which is run before ready_list and is never stolen
+   from. */
+struct cpu {
+	int id;                      /* Index into cpus[]. */
+	uint8_t lapic_id;            /* Local APIC ID. */
+	volatile bool started;       /* Set by the CPU itself once it is up. */
+	bool online;                 /* Runs threads. */
+	struct thread *idle_thread;  /* Runs when the run queue is empty. */
+	struct thread *volatile running; /* Thread it is running. */
+	unsigned thread_ticks;       /* # of timer ticks since last yield. */
+	unsigned balance_ticks;      /* # of timer ticks since last rebalance. */
+	struct thread *switching;    /* Thread whose context is being saved. */
+	bool rcu_online;             /* Runs threads, so may run RCU readers. */
+	uint64_t rcu_qs;             /* Last grace period it was quiescent in. */
+	struct thread *fpu_owner;    /* Thread whose state is in the FPU. */
+
+	/* Run queue. */
+	struct spinlock rq_lock;
+	struct list ready_list[PRI_MAX + 1]; /* 우선순위별 FIFO 실행 큐. */
+	uint64_t ready_bitmap;       /* i번 비트: ready_list[i]가 비어있지 않음. */
+	int ready_cnt;               /* 실행 큐에 들어있는 쓰레드 수. */
+	struct list dl_list;         /* EDF 쓰레드들, 절대 마감 오름차순. */
+};
+
+extern struct cpu cpus[CPU_MAX];
+extern int cpu_cnt;
+extern int cpu_online_cnt;
+
+void cpu_init (void);
+void cpu_start_aps (void);
+struct cpu *cpu_current (void);
+void cpu_kick (struct cpu *);
+
+#endif /* threads/cpu.h */
@@ -0,0 +1,33 @@
+#ifndef THREADS_LOCKSTAT_H
+#define THREADS_LOCKSTAT_H
+
+#include <stdint.h>
+
+/* Lock contention profiler.
+
+   Built only with `make LOCKSTAT=1', which defines LOCKSTAT.
+   Every struct lock and struct spinlock then counts into the
+   lockstat entry of the place that initialized it, or of the name
+   given to it with lock_set_name() or spinlock_set_name(), so
+   that all the locks of one kind (say, the malloc descriptors)
+   add up in one line.  lockstat_print()
+   dumps the table; init.c calls it for the `lockstat' action
+   and at power_off().
+
+   Times are in TSC cycles.  The counters are updated without
+   disabling interrupts, so hold_max_cycles is approximate when
+   several locks of one entry are released at the same time. */
+struct lockstat {
+	const char *name;           /* Name, or NULL for an unnamed site. */
+	void *site;                 /* Caller of lock_init() if unnamed. */
+	uint64_t acquired;          /* # of acquisitions. */
+	uint64_t contended;         /* # that had to spin or sleep. */
+	uint64_t wait_cycles;       /* Total cycles spent spinning or asleep. */
+	uint64_t hold_max_cycles;   /* Longest time held. */
+};
+
+struct lockstat *lockstat_site (void *site);
+struct lockstat *lockstat_named (const char *name);
+void lockstat_print (void);
+
+#endif /* threads/lockstat.h */
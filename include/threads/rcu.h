@@ -0,0 +1,86 @@
+#ifndef THREADS_RCU_H
+#define THREADS_RCU_H
+
+#include <debug.h>
+#include <list.h>
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Read-copy update (RCU).
+
+   Readers of an RCU-protected structure bracket their accesses
+   with rcu_read_lock() and rcu_read_unlock(), which only touch
+   the running thread, and never wait for writers.  A writer
+   publishes a new version with rcu_assign_pointer() or one of
+   the list_*_rcu() functions, unlinks the old one, and frees it
+   only after a grace period, by which time every reader that
+   could still see it has left its read-side critical section:
+   either synchronously with synchronize_rcu() or from a callback
+   registered with call_rcu().  Writers still need their own
+   mutual exclusion against each other.
+
+   Read-side critical sections may be preempted but should not
+   sleep, since that holds up every grace period. */
+
+/* Callback for call_rcu(). */
+struct rcu_head;
+typedef void rcu_func (struct rcu_head *);
+
+/* Embedded in the structure that call_rcu() frees. */
+struct rcu_head {
+	struct list_elem elem;      /* Element in a callback list. */
+	rcu_func *func;             /* Called after the grace period. */
+};
+
+void rcu_init (void);
+void rcu_start (void);
+void rcu_cpu_online (struct cpu *);
+
+void call_rcu (struct rcu_head *, rcu_func *);
+void synchronize_rcu (void);
+
+void rcu_note_context_switch (struct thread *prev);
+void rcu_tick (void);
+void rcu_read_unlock_special (void);
+
+/* Begins a read-side critical section.  May nest. */
+static inline void
+rcu_read_lock (void) {
+	thread_current ()->rcu_nesting++;
+	barrier ();
+}
+
+/* Ends a read-side critical section.  Only takes the slow path if
+   the thread was preempted inside it. */
+static inline void
+rcu_read_unlock (void) {
+	struct thread *t = thread_current ();
+
+	barrier ();
+	ASSERT (t->rcu_nesting > 0);
+	if (--t->rcu_nesting == 0 && t->rcu_blocked)
+		rcu_read_unlock_special ();
+}
+
+/* Returns true if the running thread is inside a read-side
+   critical section. */
+static inline bool
+rcu_read_lock_held (void) {
+	return thread_current ()->rcu_nesting > 0;
+}
+
+/* Reads an RCU-protected pointer P inside a read-side critical
+   section.  x86 does not reorder dependent loads, so it is enough
+   that the compiler loads P exactly once. */
+#define rcu_dereference(P) (*(volatile __typeof__ (P) *) &(P))
+
+/* Publishes V in the RCU-protected pointer P.  Every store that
+   initialized *V is made before it, so readers that see V also
+   see its contents. */
+#define rcu_assign_pointer(P, V)                \
+	do {                                        \
+		barrier ();                             \
+		*(volatile __typeof__ (P) *) &(P) = (V); \
+	} while (0)
+
+#endif /* threads/rcu.h */
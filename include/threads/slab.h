@@ -0,0 +1,21 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object cache.  Opaque outside slab.c. */
+struct kmem_cache;
+
+/* Constructor, run once on each object when its slab is created. */
+typedef void kmem_ctor_func (void *obj);
+
+void kmem_cache_init (void);
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *ctor);
+void kmem_cache_destroy (struct kmem_cache *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *obj);
+size_t kmem_cache_objs_per_slab (const struct kmem_cache *);
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
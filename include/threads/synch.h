@@ -3,6 +3,7 @@
 
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
@@ -12,18 +13,33 @@ struct semaphore {
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_timeout (struct semaphore *, int64_t ticks);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
-/* Lock. */
+/* Lock.
+
+   OWNER is the holding thread, or 0 if the lock is free, ORed
+   with LOCK_WAITERS while some thread may be waiting in WAITERS.
+   It is only changed with cmpxchg(), so that an uncontended lock
+   is acquired and released without disabling interrupts. */
 struct lock {
+	volatile uint64_t owner;    /* Holder | LOCK_WAITERS, or 0. */
 	struct thread *holder;      /* Thread holding lock (for debugging). */
-	struct semaphore semaphore; /* Binary semaphore controlling access. */
-	int8_t donation_list[64];
+	struct list waiters;        /* Threads blocked on the lock. */
+	uint64_t donation_bitmap;   /* 이 락 때문에 holder가 기부받은 우선순위들. */
+	struct list_elem elem;      /* holder의 held_locks 원소. */
+#ifdef LOCKSTAT
+	struct lockstat *stat;      /* Profile entry (threads/lockstat.h). */
+	uint64_t acquired_tsc;      /* rdtsc() when last acquired. */
+#endif
 };
 
+#define LOCK_WAITERS 1          /* Threads are page aligned. */
+
 void lock_init (struct lock *);
+void lock_set_name (struct lock *, const char *name);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
@@ -36,9 +52,64 @@ struct condition {
 
 void cond_init (struct condition *);
 void cond_wait (struct condition *, struct lock *);
+bool cond_wait_timeout (struct condition *, struct lock *, int64_t ticks);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Reader-writer lock.  Any number of threads may hold it for
+   reading at the same time, or a single thread for writing.
+   Writers are preferred: once a writer waits, new readers wait
+   too, so a steady stream of readers cannot starve it.  A waiting
+   thread donates its priority to every current holder.  Not
+   recursive in either mode. */
+struct rwlock {
+	int readers;                /* # of threads holding it for reading. */
+	struct thread *writer;      /* Thread holding it for writing. */
+	int waiting_writers;        /* # of threads waiting to write. */
+	struct list holders;        /* struct rwlock_hold of every holder. */
+	struct list read_waiters;   /* Threads waiting to read. */
+	struct list write_waiters;  /* Threads waiting to write. */
+};
+
+/* One thread's hold on an rwlock.  Kept in struct thread, so that
+   a reader can be found and receive donations without any
+   allocation. */
+struct rwlock_hold {
+	struct rwlock *rwlock;      /* Held rwlock, or NULL if unused. */
+	struct thread *thread;      /* Holding thread. */
+	uint64_t donation_bitmap;   /* 이 hold 때문에 기부받은 우선순위들. */
+	struct list_elem elem;      /* rwlock의 holders 원소. */
+};
+
+/* Maximum number of rwlocks a thread can hold at once. */
+#define RWLOCK_HOLD_MAX 4
+
+void rwlock_init (struct rwlock *);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_read_release (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_write_release (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+
+/* Spinlock.  Protects data that other CPUs may touch at the same
+   time, such as a per-CPU run queue.  Interrupts must be off
+   while one is held, so that the holder is never preempted on
+   its own CPU. */
+struct spinlock {
+	volatile uint32_t locked;   /* Nonzero while held. */
+	struct cpu *holder;         /* CPU holding the lock (for debugging). */
+#ifdef LOCKSTAT
+	struct lockstat *stat;      /* Profile entry (threads/lockstat.h). */
+	uint64_t acquired_tsc;      /* rdtsc() when last acquired. */
+#endif
+};
+
+void spinlock_init (struct spinlock *);
+void spinlock_set_name (struct spinlock *, const char *name);
+void spinlock_acquire (struct spinlock *);
+void spinlock_release (struct spinlock *);
+bool spinlock_held_by_current_cpu (const struct spinlock *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -4,11 +4,16 @@
 #include <debug.h>
 #include <list.h>
 #include <stdint.h>
+#include "devices/timer.h"
 #include "threads/interrupt.h"
+#include "threads/synch.h"
 #ifdef VM
 #include "vm/vm.h"
 #endif
 
+struct cpu;
+struct uthread;
+
 /* States in a thread's life cycle. */
 enum thread_status
 {
@@ -79,6 +84,19 @@ typedef int tid_t;
  * the `magic' member of the running thread's `struct thread' is
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
+/* Per-thread accounting, kept by schedule() and thread_unblock().
+   Times are in nanoseconds of timer_ns(). */
+struct thread_stats
+{
+	int64_t run_ns;			/* RUNNING으로 보낸 시간. */
+	int64_t ready_ns;		/* READY로 기다린 시간 합 (실행 큐 지연). */
+	int64_t ready_max_ns;	/* 가장 길었던 한 번의 READY 대기. */
+	int64_t lock_ns;		/* lock_acquire()에서 잠들어 있던 시간. */
+	uint64_t dispatches;	/* CPU를 받은 횟수. */
+	uint64_t voluntary;		/* 잠들거나 끝나서 CPU를 내놓은 횟수. */
+	uint64_t involuntary;	/* READY인 채로 밀려난 횟수. */
+};
+
 /* The `elem' member has a dual purpose.  It can be an element in
  * the run queue (thread.c), or it can be an element in a
  * semaphore wait list (synch.c).  It can be used these two ways
@@ -92,14 +110,25 @@ struct thread
 	enum thread_status status; /* Thread state. */
 	char name[16];			   /* Name (for debugging purposes). */
 	int priority;			   /* Priority. */
+	int effective_priority;	   /* 기부를 반영한 우선순위. thread_update_priority()가 갱신. */
+	int ready_pri;			   /* 들어가 있는 실행 큐 (READY일 때만 유효). */
+	struct cpu *cpu;		   /* 실행 중이거나 실행 큐에 들어갈 CPU. */
+	bool bound;				   /* 다른 CPU로 옮기지 않는다. */
 
 	
-	int8_t donation_list[64]; /* 도네이션 리스트 */
-	int donation_cnt;
+	uint64_t donation_bitmap; /* 기부받은 우선순위들 (i번 비트 = 우선순위 i). */
+	struct list held_locks;	  /* 가지고 있는 락들 (struct lock의 elem). */
+	struct rwlock_hold rw_holds[RWLOCK_HOLD_MAX]; /* 가지고 있는 rwlock들. */
 
 	struct lock * wait_on_lock;
+	struct rwlock *wait_on_rwlock;
+
+	/* Owned by rcu.c. */
+	int rcu_nesting;			/* RCU 읽기 구역 중첩 깊이. */
+	bool rcu_blocked;			/* 읽기 구역 안에서 밀려나 blocked_list에 있는가 */
+	uint64_t rcu_blocked_gp;	/* 붙잡고 있는 첫 grace period. */
+	struct list_elem rcu_elem;	/* blocked_list 원소 */
 	int nice;
-	int64_t wake_tick;
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem; /* List element. */
 
@@ -107,10 +136,31 @@ struct thread
 	struct list_elem all_elem;
 	/* recent_cpu */
 	int recent_cpu;
+	int64_t recent_epoch;		/* recent_cpu에 반영된 마지막 감쇠 epoch */
+	bool decay_pending;			/* decay_list에 들어있는가 */
+	struct list_elem decay_elem; /* decay_list 원소 */
+
+	struct thread_stats stats;	/* 쓰레드별 통계. */
+	int64_t stats_stamp;		/* 마지막 상태 전환 시각 (timer_ns). */
+
+	/* 마감(EDF) 클래스.  dl_runtime이 0이면 일반 쓰레드.  단위는 틱. */
+	int64_t dl_runtime;			/* 주기마다 받는 실행 시간. */
+	int64_t dl_deadline;		/* 주기 시작부터의 상대 마감. */
+	int64_t dl_period;			/* 주기. */
+	int64_t dl_start;			/* 현재 주기의 시작 시각. */
+	int64_t dl_budget;			/* 이번 주기에 남은 실행 시간. */
+	bool dl_queued;				/* cpu->dl_list에 들어있는가 */
+	struct timeout dl_timer;	/* 다 쓴 예산을 다음 주기에 채운다. */
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
 	uint64_t *pml4; /* Page map level 4 */
+	struct thread *leader;        /* 주소 공간의 주인. 메인 쓰레드면 자기 자신. */
+	struct uthread *uthread;      /* 사용자 쓰레드의 join 정보. 메인 쓰레드면 NULL. */
+	struct list uthreads;         /* 메인 쓰레드가 기다릴 사용자 쓰레드들. */
+	uint64_t uthread_slots;       /* 사용 중인 사용자 쓰레드 스택 슬롯. */
+	bool exiting;                 /* 메인 쓰레드가 끝나는 중. 다른 쓰레드도 끝낸다. */
+	void *fpu;                    /* 저장된 FPU/SSE 상태, 처음 쓸 때 할당. */
 #endif
 #ifdef VM
   /* Table for whole virtual memory owned by thread. */
@@ -119,6 +169,7 @@ struct thread
 
 	/* Owned by thread.c. */
 	struct intr_frame tf; /* Information for switching */
+	uint64_t switch_sp;	  /* switch_threads()가 저장한 rsp, 없으면 0. */
 	unsigned magic;		  /* Detects stack overflow. */
 };
 
@@ -127,14 +178,24 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, voluntary switches save the whole intr_frame and
+   resume through iretq, as they used to.  Only for comparing the
+   two paths in the switch-bench test.
+   참이면 예전처럼 intr_frame 전체를 저장한다 (벤치마크용). */
+extern bool thread_switch_full;
+
 void thread_init(void);
 void thread_start(void);
+void thread_init_cpu(struct cpu *);
+struct thread *thread_create_idle(struct cpu *);
+void thread_start_ap(struct cpu *) NO_RETURN;
 
 void thread_tick(void);
 void thread_print_stats(void);
 
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
+tid_t thread_create_bound(const char *name, int priority, thread_func *, void *);
 
 void thread_block(void);
 void thread_unblock(struct thread *);
@@ -149,27 +210,24 @@ void thread_yield(void);
 int thread_get_priority(void);
 void thread_set_priority(int);
 int thread_get_priority_manual(struct thread *t);
+void thread_update_priority(struct thread *t);
 
 int thread_get_nice(void);
 void thread_set_nice(int);
 int thread_get_recent_cpu(void);
 int thread_get_load_avg(void);
 
-void do_iret(struct intr_frame *tf);
+bool thread_set_deadline(int64_t runtime, int64_t deadline, int64_t period);
 
-/*
-	timer_sleep() 구현
-*/
-bool cmp_wake_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
-void thread_sleep(int64_t ticks);
-void thread_wake(int64_t ticks);
+bool thread_get_stats(tid_t tid, struct thread_stats *);
+void thread_print_all_stats(void);
 
+void do_iret(struct intr_frame *tf);
 
 /*
 	priority
 */
 bool cmp_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
-bool cmp_recent(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED);
 void thread_relocate_ready(struct thread *t);
 
 /*mlfq*/
@@ -0,0 +1,13 @@
+#ifndef USERPROG_FPU_H
+#define USERPROG_FPU_H
+
+#include <stdbool.h>
+
+struct thread;
+
+void fpu_init (void);
+void fpu_switch (struct thread *next);
+bool fpu_trap (void);
+void fpu_release (struct thread *);
+
+#endif /* userprog/fpu.h */
@@ -10,4 +10,9 @@ int process_wait (tid_t);
 void process_exit (void);
 void process_activate (struct thread *next);
 
+tid_t process_thread_create (void *entry, void *fn, void *arg);
+int process_thread_join (tid_t tid, uint64_t *retval);
+void process_thread_exit (uint64_t retval) NO_RETURN;
+void process_check_exit (void);
+
 #endif /* userprog/process.h */
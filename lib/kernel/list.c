@@ -257,6 +257,66 @@ list_remove(struct list_elem *elem)
 	return elem->next;
 }
 
+/* RCU variants.
+
+   These let readers walk a list forward, with list_next_rcu(),
+   while a writer changes it, as long as the readers are inside an
+   RCU read-side critical section (see threads/rcu.h).  Writers
+   must still exclude each other.  x86 does not reorder stores
+   with other stores, so only the compiler has to be kept from
+   reordering them. */
+#define rcu_barrier() asm volatile ("" : : : "memory")
+
+/* Like list_insert(), but ELEM is fully linked before it becomes
+   reachable, so a concurrent reader sees either the old list or
+   the new one. */
+void list_insert_rcu(struct list_elem *before, struct list_elem *elem)
+{
+	ASSERT(is_interior(before) || is_tail(before));
+	ASSERT(elem != NULL);
+
+	elem->prev = before->prev;
+	elem->next = before;
+	rcu_barrier();
+	*(struct list_elem *volatile *)&before->prev->next = elem;
+	before->prev = elem;
+}
+
+/* Like list_push_front(), for a list read under RCU. */
+void list_push_front_rcu(struct list *list, struct list_elem *elem)
+{
+	list_insert_rcu(list_begin(list), elem);
+}
+
+/* Like list_push_back(), for a list read under RCU. */
+void list_push_back_rcu(struct list *list, struct list_elem *elem)
+{
+	list_insert_rcu(list_end(list), elem);
+}
+
+/* Like list_remove(), but leaves ELEM's own links alone, so a
+   reader that is standing on ELEM can still move on to the rest
+   of the list.  ELEM may not be reused or freed until a grace
+   period has passed. */
+struct list_elem *
+list_remove_rcu(struct list_elem *elem)
+{
+	ASSERT(is_interior(elem));
+	*(struct list_elem *volatile *)&elem->prev->next = elem->next;
+	elem->next->prev = elem->prev;
+	return elem->next;
+}
+
+/* Returns the element after ELEM in a list that may be changed
+   concurrently by the RCU variants above.  Must be called inside
+   an RCU read-side critical section. */
+struct list_elem *
+list_next_rcu(struct list_elem *elem)
+{
+	ASSERT(is_head(elem) || is_interior(elem));
+	return *(struct list_elem *volatile *)&elem->next;
+}
+
 /* Removes the front element from LIST and returns it.
    Undefined behavior if LIST is empty before removal. */
 struct list_elem *
@@ -0,0 +1,111 @@
+#include <pthread.h>
+#include <limits.h>
+#include <stddef.h>
+
+/* Entered by every new thread in user mode: runs START (ARG) and
+   hands its return value to pthread_join(). */
+static void
+pthread_entry (void *start, void *arg) {
+	void *(*fn) (void *) = start;
+	pthread_exit (fn (arg));
+}
+
+int
+pthread_create (pthread_t *thread, void *(*start) (void *), void *arg) {
+	tid_t tid = thread_create (pthread_entry, start, arg);
+
+	if (tid == TID_ERROR)
+		return -1;
+	*thread = tid;
+	return 0;
+}
+
+int
+pthread_join (pthread_t thread, void **retval) {
+	return thread_join (thread, retval);
+}
+
+void
+pthread_exit (void *retval) {
+	thread_exit (retval);
+}
+
+/* Atomically replaces *P by NEW if it equals OLD, and returns the
+   value it had. */
+static int
+cmpxchg (int *p, int old, int new) {
+	__atomic_compare_exchange_n (p, &old, new, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+	return old;
+}
+
+int
+pthread_mutex_init (pthread_mutex_t *mutex) {
+	mutex->state = 0;
+	return 0;
+}
+
+/* Takes MUTEX without entering the kernel unless it is already
+   held; see Drepper, "Futexes Are Tricky", mutex 2. */
+int
+pthread_mutex_lock (pthread_mutex_t *mutex) {
+	int c = cmpxchg (&mutex->state, 0, 1);
+
+	if (c == 0)
+		return 0;
+	if (c != 2)
+		c = __atomic_exchange_n (&mutex->state, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		futex_wait (&mutex->state, 2, -1);
+		c = __atomic_exchange_n (&mutex->state, 2, __ATOMIC_ACQUIRE);
+	}
+	return 0;
+}
+
+int
+pthread_mutex_trylock (pthread_mutex_t *mutex) {
+	return cmpxchg (&mutex->state, 0, 1) == 0 ? 0 : -1;
+}
+
+/* Releases MUTEX, waking one waiter only if there may be one. */
+int
+pthread_mutex_unlock (pthread_mutex_t *mutex) {
+	if (__atomic_exchange_n (&mutex->state, 0, __ATOMIC_RELEASE) == 2)
+		futex_wake (&mutex->state, 1);
+	return 0;
+}
+
+int
+pthread_cond_init (pthread_cond_t *cond) {
+	cond->seq = 0;
+	return 0;
+}
+
+/* Releases MUTEX and sleeps until COND is signaled, then
+   reacquires MUTEX.  May wake spuriously, as in POSIX. */
+int
+pthread_cond_wait (pthread_cond_t *cond, pthread_mutex_t *mutex) {
+	int seq = __atomic_load_n (&cond->seq, __ATOMIC_RELAXED);
+
+	pthread_mutex_unlock (mutex);
+	futex_wait (&cond->seq, seq, -1);
+
+	/* 깨어난 뒤 잠금이 다시 경합될 수 있으므로 2로 잡는다. */
+	while (__atomic_exchange_n (&mutex->state, 2, __ATOMIC_ACQUIRE) != 0)
+		futex_wait (&mutex->state, 2, -1);
+	return 0;
+}
+
+int
+pthread_cond_signal (pthread_cond_t *cond) {
+	__atomic_add_fetch (&cond->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cond->seq, 1);
+	return 0;
+}
+
+int
+pthread_cond_broadcast (pthread_cond_t *cond) {
+	__atomic_add_fetch (&cond->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cond->seq, INT_MAX);
+	return 0;
+}
@@ -194,3 +194,34 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+int
+futex_wait (int *addr, int expected, int timeout_ms) {
+	return syscall3 (SYS_FUTEX_WAIT, addr, expected, timeout_ms);
+}
+
+int
+futex_wake (int *addr, int n) {
+	return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+tid_t
+thread_create (void (*entry) (void *fn, void *arg), void *fn, void *arg) {
+	return (tid_t) syscall3 (SYS_THREAD_CREATE, entry, fn, arg);
+}
+
+int
+thread_join (tid_t tid, void **retval) {
+	return syscall2 (SYS_THREAD_JOIN, tid, retval);
+}
+
+void
+thread_exit (void *retval) {
+	syscall1 (SYS_THREAD_EXIT, retval);
+	NOT_REACHED ();
+}
+
+bool
+thread_stats (tid_t tid, struct thread_stats *stats) {
+	return syscall2 (SYS_THREAD_STATS, tid, stats);
+}
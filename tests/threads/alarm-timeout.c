@@ -0,0 +1,81 @@
+/* Tests sema_down_timeout(), cond_wait_timeout(), and
+   timeout_cancel().  A down on a semaphore nobody ups must give
+   up after the given number of ticks, while one that is upped in
+   time must succeed without waiting for the timeout. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func upper;
+static timeout_func never_called;
+
+void
+test_alarm_timeout (void) 
+{
+  struct semaphore sema;
+  struct lock lock;
+  struct condition cond;
+  struct timeout to;
+  int64_t start, elapsed;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&sema, 0);
+  start = timer_ticks ();
+  if (sema_down_timeout (&sema, 10))
+    fail ("sema_down_timeout succeeded on a zero semaphore");
+  elapsed = timer_elapsed (start);
+  if (elapsed < 10)
+    fail ("sema_down_timeout returned after %lld ticks", elapsed);
+  msg ("sema_down_timeout timed out.");
+
+  thread_create ("upper", PRI_DEFAULT, upper, &sema);
+  start = timer_ticks ();
+  if (!sema_down_timeout (&sema, 1000))
+    fail ("sema_down_timeout timed out although upped");
+  if (timer_elapsed (start) >= 1000)
+    fail ("sema_down_timeout waited for the whole timeout");
+  msg ("sema_down_timeout succeeded.");
+
+  lock_init (&lock);
+  cond_init (&cond);
+  lock_acquire (&lock);
+  if (cond_wait_timeout (&cond, &lock, 10))
+    fail ("cond_wait_timeout was signaled by nobody");
+  if (!lock_held_by_current_thread (&lock))
+    fail ("cond_wait_timeout did not reacquire the lock");
+  cond_signal (&cond, &lock);
+  lock_release (&lock);
+  msg ("cond_wait_timeout timed out.");
+
+  timeout_init (&to, never_called, NULL);
+  timeout_add (&to, timer_ticks () + 5);
+  if (!timeout_cancel (&to))
+    fail ("pending timeout could not be canceled");
+  if (timeout_cancel (&to))
+    fail ("canceled timeout was still pending");
+  timer_sleep (10);
+  msg ("timeout canceled.");
+
+  pass ();
+}
+
+static void
+upper (void *sema_) 
+{
+  struct semaphore *sema = sema_;
+
+  timer_sleep (5);
+  sema_up (sema);
+}
+
+static void
+never_called (void *aux UNUSED) 
+{
+  fail ("canceled timeout fired");
+}
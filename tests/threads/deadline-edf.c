@@ -0,0 +1,84 @@
+/* Tests the deadline scheduling class.  Three deadline threads
+   woken in the same tick must run in order of deadline, not of
+   priority, admission control must refuse to overcommit the CPU,
+   and a deadline thread that uses up its runtime must be
+   throttled so that other threads get to run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func edf_thread;
+static thread_func spinner;
+
+static int64_t wake_at;
+static volatile bool stop, spinner_done;
+static struct semaphore done;
+
+void
+test_deadline_edf (void) 
+{
+  int i;
+
+  sema_init (&done, 0);
+
+  /* Later deadlines get higher priorities. */
+  wake_at = timer_ticks () + 20;
+  for (i = 0; i < 3; i++) 
+    {
+      int deadline = 30 - 10 * i;
+      char name[16];
+      snprintf (name, sizeof name, "deadline %d", deadline);
+      thread_create (name, PRI_DEFAULT + 3 - i, edf_thread, (void *) (intptr_t) deadline);
+    }
+
+  if (thread_set_deadline (40, 50, 50))
+    fail ("admitted a thread that overcommits the CPU");
+  msg ("Overcommit rejected.");
+  if (thread_set_deadline (5, 3, 50))
+    fail ("admitted runtime > deadline");
+  msg ("Bad parameters rejected.");
+
+  for (i = 0; i < 3; i++)
+    sema_down (&done);
+
+  /* Without budget enforcement, the spinner would keep us off the
+     CPU until it gives up. */
+  thread_create ("spinner", PRI_MIN, spinner, NULL);
+  timer_sleep (5);
+  if (spinner_done)
+    fail ("deadline thread ran past its runtime");
+  stop = true;
+  sema_down (&done);
+  msg ("Spinner throttled.");
+}
+
+static void
+edf_thread (void *deadline_) 
+{
+  int deadline = (intptr_t) deadline_;
+
+  if (!thread_set_deadline (5, deadline, 50))
+    fail ("deadline %d rejected", deadline);
+  msg ("Deadline %d admitted.", deadline);
+
+  timer_sleep (wake_at - timer_ticks ());
+  msg ("Deadline %d ran.", deadline);
+  sema_up (&done);
+}
+
+static void
+spinner (void *aux UNUSED) 
+{
+  int64_t start = timer_ticks ();
+
+  if (!thread_set_deadline (3, 100, 100))
+    fail ("spinner rejected");
+  while (!stop && timer_elapsed (start) < 50)
+    continue;
+  spinner_done = true;
+  sema_up (&done);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(deadline-edf) begin
+(deadline-edf) Deadline 30 admitted.
+(deadline-edf) Deadline 20 admitted.
+(deadline-edf) Deadline 10 admitted.
+(deadline-edf) Overcommit rejected.
+(deadline-edf) Bad parameters rejected.
+(deadline-edf) Deadline 10 ran.
+(deadline-edf) Deadline 20 ran.
+(deadline-edf) Deadline 30 ran.
+(deadline-edf) Spinner throttled.
+(deadline-edf) end
+EOF
+pass;
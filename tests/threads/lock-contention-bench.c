@@ -0,0 +1,152 @@
+/* Compares struct lock with a lock built from a binary semaphore,
+   which is how lock_acquire() used to work: every acquire and
+   release disables interrupts and goes through the semaphore.
+
+   Each lock is timed first without contention, then with
+   THREAD_CNT threads of equal priority incrementing a shared
+   counter, where the timer interrupt preempts threads inside the
+   critical section.  This is a benchmark: it only fails if the
+   counter comes out wrong. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ITER_CNT 200000
+#define THREAD_CNT 4
+
+/* Operations of one of the two locks. */
+struct bench_ops 
+  {
+    const char *name;
+    void (*acquire) (void *);
+    void (*release) (void *);
+    void *lock;
+  };
+
+struct bench_info 
+  {
+    const struct bench_ops *ops;
+    int64_t *counter;
+    struct semaphore *done;
+  };
+
+static thread_func counter_thread;
+static void lock_ops_acquire (void *);
+static void lock_ops_release (void *);
+static void sema_ops_acquire (void *);
+static void sema_ops_release (void *);
+static void run_bench (const struct bench_ops *);
+
+void
+test_lock_contention_bench (void) 
+{
+  struct lock lock;
+  struct semaphore sema;
+  struct bench_ops ops[2] = 
+    {
+      {"lock", lock_ops_acquire, lock_ops_release, &lock},
+      {"semaphore", sema_ops_acquire, sema_ops_release, &sema},
+    };
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  sema_init (&sema, 1);
+
+  msg ("%d acquire/release pairs, %d threads when contended.",
+       ITER_CNT, THREAD_CNT);
+  run_bench (&ops[0]);
+  run_bench (&ops[1]);
+}
+
+static void
+run_bench (const struct bench_ops *ops) 
+{
+  struct bench_info info;
+  struct semaphore done;
+  int64_t counter = 0;
+  int64_t start, uncontended, contended;
+  int i;
+
+  start = timer_ns ();
+  for (i = 0; i < ITER_CNT; i++) 
+    {
+      ops->acquire (ops->lock);
+      counter++;
+      ops->release (ops->lock);
+    }
+  uncontended = timer_ns () - start;
+
+  sema_init (&done, 0);
+  info.ops = ops;
+  info.counter = &counter;
+  info.done = &done;
+  start = timer_ns ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+      snprintf (name, sizeof name, "%s %d", ops->name, i);
+      thread_create (name, PRI_DEFAULT, counter_thread, &info);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  contended = timer_ns () - start;
+
+  if (counter != 2 * ITER_CNT)
+    fail ("%s: counter is %"PRId64", expected %d", ops->name, counter,
+          2 * ITER_CNT);
+  msg ("%s: %"PRId64" ns per pair uncontended, %"PRId64" ns contended.",
+       ops->name, uncontended / ITER_CNT, contended / ITER_CNT);
+}
+
+static void
+counter_thread (void *info_) 
+{
+  struct bench_info *info = info_;
+  const struct bench_ops *ops = info->ops;
+  int i;
+
+  for (i = 0; i < ITER_CNT / THREAD_CNT; i++) 
+    {
+      int64_t value;
+
+      ops->acquire (ops->lock);
+      /* Read-modify-write in steps, so preemption in between
+         would lose updates without the lock. */
+      value = *info->counter;
+      barrier ();
+      *info->counter = value + 1;
+      ops->release (ops->lock);
+    }
+  sema_up (info->done);
+}
+
+static void
+lock_ops_acquire (void *lock) 
+{
+  lock_acquire (lock);
+}
+
+static void
+lock_ops_release (void *lock) 
+{
+  lock_release (lock);
+}
+
+static void
+sema_ops_acquire (void *sema) 
+{
+  sema_down (sema);
+}
+
+static void
+sema_ops_release (void *sema) 
+{
+  sema_up (sema);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+foreach my $name ('lock', 'semaphore') {
+    fail "missing timings for $name\n"
+      unless grep (/\) $name: \d+ ns per pair uncontended, \d+ ns contended\./, @output);
+}
+
+pass;
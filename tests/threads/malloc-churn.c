@@ -0,0 +1,57 @@
+/* Allocates blocks of every size class from malloc(), frees them
+   in a scrambled order so that arenas empty out one at a time,
+   and checks that no block was overwritten.  Then times a
+   malloc()/free() pair of the size of a disk sector, like the
+   bounce buffer in inode_read_at().  This is a benchmark: it only
+   fails if a block comes out wrong. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <random.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/malloc.h"
+#include "devices/timer.h"
+
+#define BLOCK_CNT 2000
+#define PAIR_CNT 100000
+
+static uint8_t *blocks[BLOCK_CNT];
+static size_t sizes[BLOCK_CNT];
+
+void
+test_malloc_churn (void) 
+{
+  int64_t start, elapsed;
+  int i, j;
+
+  random_init (0);
+  for (i = 0; i < BLOCK_CNT; i++) 
+    {
+      sizes[i] = random_ulong () % 1024 + 1;
+      blocks[i] = malloc (sizes[i]);
+      if (blocks[i] == NULL)
+        fail ("malloc (%zu) failed", sizes[i]);
+      memset (blocks[i], i, sizes[i]);
+    }
+
+  /* Free the blocks in seven interleaved passes. */
+  for (j = 0; j < 7; j++)
+    for (i = j; i < BLOCK_CNT; i += 7) 
+      {
+        size_t k;
+
+        for (k = 0; k < sizes[i]; k++)
+          if (blocks[i][k] != (uint8_t) i)
+            fail ("block %d of %zu bytes was overwritten", i, sizes[i]);
+        free (blocks[i]);
+      }
+  msg ("%d blocks of mixed sizes allocated and freed.", BLOCK_CNT);
+
+  start = timer_ns ();
+  for (i = 0; i < PAIR_CNT; i++)
+    free (malloc (512));
+  elapsed = timer_ns () - start;
+  msg ("%"PRId64" ns per 512-byte malloc/free pair.", elapsed / PAIR_CNT);
+}
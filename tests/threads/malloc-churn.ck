@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "blocks were not all checked\n"
+  unless grep (/\d+ blocks of mixed sizes allocated and freed\./, @output);
+fail "missing timings in output\n"
+  unless grep (/\d+ ns per 512-byte malloc\/free pair\./, @output);
+
+pass;
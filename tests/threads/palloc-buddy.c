@@ -0,0 +1,127 @@
+/* Stresses the page allocator with a mix of block sizes.
+
+   Allocates blocks of 1 to MAX_PAGES pages from the user pool,
+   which the threads tests do not otherwise use, until the pool
+   runs out, then frees a random half of them, ROUND_CNT times.
+   Every block is tagged at both ends to catch overlapping
+   allocations.  Finally everything is freed and the largest
+   block that can be allocated must be as large as it was at the
+   start, which fails if freed blocks are not merged with their
+   buddies again. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <random.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "devices/timer.h"
+
+#define ROUND_CNT 50
+#define MAX_BLOCKS 1024
+#define MAX_PAGES 17
+
+struct block 
+  {
+    uint64_t *pages;
+    size_t page_cnt;
+  };
+
+static struct block blocks[MAX_BLOCKS];
+static int block_cnt;
+static int64_t op_cnt;
+
+static size_t largest_block (void);
+static void tag (struct block *, int idx);
+static void fill (void);
+static void release (int idx);
+
+void
+test_palloc_buddy (void) 
+{
+  size_t before, after;
+  int64_t start, elapsed;
+  int round, i;
+
+  random_init (0);
+  before = largest_block ();
+
+  start = timer_ns ();
+  for (round = 0; round < ROUND_CNT; round++) 
+    {
+      fill ();
+      for (i = 0; i < block_cnt; i++)
+        if (random_ulong () % 2)
+          release (i--);
+    }
+  while (block_cnt > 0)
+    release (block_cnt - 1);
+  elapsed = timer_ns () - start;
+
+  after = largest_block ();
+  if (after != before)
+    fail ("largest free block shrank from %zu to %zu pages", before, after);
+  msg ("%d rounds of mixed allocations, largest free block unchanged.",
+       ROUND_CNT);
+  msg ("%"PRId64" ns per allocation or free.", elapsed / op_cnt);
+}
+
+/* Returns the number of pages in the largest power-of-two block
+   that can be allocated from the user pool. */
+static size_t
+largest_block (void) 
+{
+  size_t page_cnt = 1;
+  void *pages;
+
+  while ((pages = palloc_get_multiple (PAL_USER, page_cnt * 2)) != NULL) 
+    {
+      palloc_free_multiple (pages, page_cnt * 2);
+      page_cnt *= 2;
+    }
+  return page_cnt;
+}
+
+/* Allocates blocks of random sizes until the pool or the array
+   runs out. */
+static void
+fill (void) 
+{
+  while (block_cnt < MAX_BLOCKS) 
+    {
+      struct block *b = &blocks[block_cnt];
+
+      b->page_cnt = random_ulong () % MAX_PAGES + 1;
+      b->pages = palloc_get_multiple (PAL_USER, b->page_cnt);
+      op_cnt++;
+      if (b->pages == NULL)
+        break;
+      tag (b, block_cnt++);
+    }
+}
+
+/* Writes IDX into the first and last words of block B. */
+static void
+tag (struct block *b, int idx) 
+{
+  b->pages[0] = idx;
+  b->pages[(b->page_cnt * PGSIZE - 1) / sizeof (uint64_t)] = idx;
+}
+
+/* Checks the tags of block IDX, frees it, and moves the last
+   block into its place. */
+static void
+release (int idx) 
+{
+  struct block *b = &blocks[idx];
+  size_t last = (b->page_cnt * PGSIZE - 1) / sizeof (uint64_t);
+
+  if (b->pages[0] != (uint64_t) idx || b->pages[last] != (uint64_t) idx)
+    fail ("block %d of %zu pages was overwritten", idx, b->page_cnt);
+  palloc_free_multiple (b->pages, b->page_cnt);
+  op_cnt++;
+
+  *b = blocks[--block_cnt];
+  if (idx < block_cnt)
+    tag (b, idx);
+}
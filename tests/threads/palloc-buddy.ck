@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "largest free block changed\n"
+  unless grep (/rounds of mixed allocations, largest free block unchanged\./, @output);
+fail "missing timings in output\n"
+  unless grep (/\d+ ns per allocation or free\./, @output);
+
+pass;
@@ -0,0 +1,120 @@
+/* Micro-benchmark for priority donation through a chain of
+   locks with thousands of waiters.
+
+   The main thread drops to PRI_MIN and acquires lock 0.  Threads
+   1..NESTING_DEPTH-1 each acquire lock[i] and then block on
+   lock[i-1], forming the same chain as priority-donate-chain.
+   Then WAITER_CNT waiters with non-decreasing priorities block
+   on the last lock, each donating through the whole chain.
+   Finally the main thread releases lock 0, which unwinds the
+   chain and hands the last lock to every waiter in turn, always
+   picking the highest-priority one.
+
+   The test reports how long both phases took and checks that
+   the waiters got the lock in order of priority. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define NESTING_DEPTH 8
+#define WAITER_CNT 2000
+
+struct lock_pair
+  {
+    struct lock *second;
+    struct lock *first;
+  };
+
+static struct lock locks[NESTING_DEPTH];
+static struct lock_pair lock_pairs[NESTING_DEPTH];
+static struct semaphore done;
+static int order[WAITER_CNT];
+static int order_cnt;
+
+static thread_func chain_thread_func;
+static thread_func waiter_thread_func;
+
+void
+test_priority_donate_chain_bench (void) 
+{
+  int64_t start, block_us, drain_us;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  thread_set_priority (PRI_MIN);
+
+  for (i = 0; i < NESTING_DEPTH; i++)
+    lock_init (&locks[i]);
+  sema_init (&done, 0);
+  order_cnt = 0;
+
+  lock_acquire (&locks[0]);
+  for (i = 1; i < NESTING_DEPTH; i++) 
+    {
+      char name[16];
+
+      snprintf (name, sizeof name, "chain %d", i);
+      lock_pairs[i].first = &locks[i];
+      lock_pairs[i].second = &locks[i - 1];
+      thread_create (name, PRI_MIN + 1, chain_thread_func, &lock_pairs[i]);
+    }
+
+  msg ("%d waiters donating through %d locks.", WAITER_CNT, NESTING_DEPTH);
+  start = timer_ns ();
+  for (i = 0; i < WAITER_CNT; i++) 
+    {
+      char name[16];
+      int priority = PRI_MIN + 1 + i * (PRI_MAX - PRI_MIN - 1) / WAITER_CNT;
+
+      snprintf (name, sizeof name, "waiter %d", i);
+      if (thread_create (name, priority, waiter_thread_func, NULL) == TID_ERROR)
+        fail ("out of memory creating waiter %d", i);
+    }
+  block_us = (timer_ns () - start) / 1000;
+  msg ("main priority after donations: %d", thread_get_priority ());
+
+  start = timer_ns ();
+  lock_release (&locks[0]);
+  for (i = 0; i < WAITER_CNT; i++)
+    sema_down (&done);
+  drain_us = (timer_ns () - start) / 1000;
+
+  if (order_cnt != WAITER_CNT)
+    fail ("only %d of %d waiters got the lock", order_cnt, WAITER_CNT);
+  for (i = 1; i < WAITER_CNT; i++)
+    if (order[i] > order[i - 1])
+      fail ("waiter with priority %d ran after one with priority %d",
+            order[i], order[i - 1]);
+  msg ("all waiters got the lock in priority order.");
+  msg ("blocking waiters took %"PRId64" us.", block_us);
+  msg ("draining waiters took %"PRId64" us.", drain_us);
+}
+
+static void
+chain_thread_func (void *locks_) 
+{
+  struct lock_pair *locks = locks_;
+
+  lock_acquire (locks->first);
+  lock_acquire (locks->second);
+  lock_release (locks->second);
+  lock_release (locks->first);
+}
+
+static void
+waiter_thread_func (void *aux UNUSED) 
+{
+  struct lock *lock = &locks[NESTING_DEPTH - 1];
+
+  lock_acquire (lock);
+  order[order_cnt++] = thread_get_priority ();
+  lock_release (lock);
+  sema_up (&done);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "main thread did not receive the top donation\n"
+  unless grep (/main priority after donations: 62$/, @output);
+fail "waiters did not get the lock in priority order\n"
+  unless grep (/all waiters got the lock in priority order\./, @output);
+fail "missing timings in output\n"
+  unless grep (/draining waiters took \d+ us\./, @output);
+
+pass;
@@ -0,0 +1,65 @@
+/* The main thread acquires an rwlock for reading.  A
+   higher-priority reader shares it right away.  Then a writer
+   blocks on it, donating its priority to the main thread, and a
+   still higher-priority reader blocks behind the waiting writer
+   and donates too.  When the main thread releases the rwlock,
+   the writer gets it first, with the reader's priority, and the
+   reader follows. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_priority_donate_rwlock (void) 
+{
+  struct rwlock rw;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw);
+  rwlock_read_acquire (&rw);
+  thread_create ("reader1", PRI_DEFAULT + 1, reader_thread_func, &rw);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  thread_create ("reader2", PRI_DEFAULT + 3, reader_thread_func, &rw);
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 3, thread_get_priority ());
+  rwlock_read_release (&rw);
+  msg ("writer, reader2 must already have finished, in that order.");
+  msg ("This thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_read_acquire (rw);
+  msg ("%s: got the rwlock for reading", thread_name ());
+  rwlock_read_release (rw);
+  msg ("%s: done", thread_name ());
+}
+
+static void
+writer_thread_func (void *rw_) 
+{
+  struct rwlock *rw = rw_;
+
+  rwlock_write_acquire (rw);
+  msg ("writer: got the rwlock for writing with priority %d",
+       thread_get_priority ());
+  rwlock_write_release (rw);
+  msg ("writer: done");
+}
@@ -0,0 +1,141 @@
+/* Tests RCU.  Reader threads walk a list inside read-side
+   critical sections, yielding in the middle of each walk, while
+   the main thread replaces its elements one at a time with the
+   RCU list functions and frees the old ones with call_rcu().  A
+   reader must never see an element that has been freed.  Then
+   synchronize_rcu() must wait for a reader that sleeps inside its
+   critical section. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/rcu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define NODE_CNT 16
+#define READER_CNT 4
+#define WALK_CNT 200
+#define REPLACE_CNT 500
+
+#define NODE_MAGIC 0x6e6f6465
+#define DEAD_MAGIC 0xdeadbeef
+
+struct node 
+  {
+    unsigned magic;
+    struct list_elem elem;
+    struct rcu_head rcu;
+  };
+
+static struct list nodes;
+static struct semaphore readers_done;
+static int freed_cnt;
+static bool reader_left;
+
+static thread_func reader_thread;
+static thread_func sleeper_thread;
+static rcu_func free_node;
+
+void
+test_rcu_list (void) 
+{
+  struct semaphore entered;
+  int i;
+
+  list_init (&nodes);
+  for (i = 0; i < NODE_CNT; i++) 
+    {
+      struct node *n = malloc (sizeof *n);
+      ASSERT (n != NULL);
+      n->magic = NODE_MAGIC;
+      list_push_back_rcu (&nodes, &n->elem);
+    }
+
+  sema_init (&readers_done, 0);
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader_thread, NULL);
+
+  for (i = 0; i < REPLACE_CNT; i++) 
+    {
+      struct node *old = list_entry (list_front (&nodes), struct node, elem);
+      struct node *n = malloc (sizeof *n);
+
+      ASSERT (n != NULL);
+      n->magic = NODE_MAGIC;
+      list_push_back_rcu (&nodes, &n->elem);
+      list_remove_rcu (&old->elem);
+      call_rcu (&old->rcu, free_node);
+      if (i % 8 == 0)
+        thread_yield ();
+    }
+  for (i = 0; i < READER_CNT; i++)
+    sema_down (&readers_done);
+  msg ("readers never saw a freed element.");
+
+  synchronize_rcu ();
+  if (freed_cnt != REPLACE_CNT)
+    fail ("%d of %d callbacks ran before synchronize_rcu returned",
+          freed_cnt, REPLACE_CNT);
+  msg ("all callbacks ran.");
+
+  sema_init (&entered, 0);
+  thread_create ("sleeper", PRI_DEFAULT, sleeper_thread, &entered);
+  sema_down (&entered);
+  synchronize_rcu ();
+  if (!reader_left)
+    fail ("synchronize_rcu returned inside a read-side critical section");
+  msg ("synchronize_rcu waited for the sleeping reader.");
+
+  while (!list_empty (&nodes))
+    free (list_entry (list_pop_front (&nodes), struct node, elem));
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < WALK_CNT; i++) 
+    {
+      struct list_elem *e;
+      int cnt = 0;
+
+      rcu_read_lock ();
+      for (e = list_next_rcu (list_head (&nodes)); e != list_end (&nodes);
+           e = list_next_rcu (e)) 
+        {
+          struct node *n = list_entry (e, struct node, elem);
+          if (n->magic != NODE_MAGIC)
+            fail ("reader saw a freed element");
+          if (++cnt == NODE_CNT / 2)
+            thread_yield ();
+        }
+      rcu_read_unlock ();
+    }
+  sema_up (&readers_done);
+}
+
+static void
+sleeper_thread (void *entered_) 
+{
+  struct semaphore *entered = entered_;
+
+  rcu_read_lock ();
+  sema_up (entered);
+  timer_sleep (10);
+  reader_left = true;
+  rcu_read_unlock ();
+}
+
+static void
+free_node (struct rcu_head *head) 
+{
+  struct node *n = list_entry (&head->elem, struct node, rcu.elem);
+
+  n->magic = DEAD_MAGIC;
+  free (n);
+  freed_cnt++;
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rcu-list) begin
+(rcu-list) readers never saw a freed element.
+(rcu-list) all callbacks ran.
+(rcu-list) synchronize_rcu waited for the sleeping reader.
+(rcu-list) end
+EOF
+pass;
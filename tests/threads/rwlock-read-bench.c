@@ -0,0 +1,150 @@
+/* Read-heavy benchmark for struct rwlock.
+
+   READER_CNT threads each hold the lock for reading HOLD_CNT
+   times, sleeping HOLD_TICKS ticks inside the critical section
+   as a stand-in for a slow read (for example, one that waits for
+   the disk).  A writer updates the shared value WRITE_CNT times
+   in between.  The same workload is then run with a plain lock,
+   which serializes the readers.
+
+   This is a benchmark: it fails only if readers never overlap
+   or a reader sees a torn write. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define READER_CNT 8
+#define HOLD_CNT 4
+#define HOLD_TICKS 5
+#define WRITE_CNT 4
+
+struct bench 
+  {
+    bool use_rwlock;            /* rwlock or plain lock? */
+    struct rwlock rw;
+    struct lock lock;
+    int value[2];               /* Written together, read together. */
+    int inside;                 /* # of readers in the critical section. */
+    int max_inside;             /* Largest INSIDE seen. */
+    struct semaphore done;
+  };
+
+static thread_func reader_thread;
+static thread_func writer_thread;
+static int64_t run_bench (struct bench *, bool use_rwlock);
+
+void
+test_rwlock_read_bench (void) 
+{
+  static struct bench b;
+  int64_t rw_ticks, lock_ticks;
+  int rw_max;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d readers holding it %d times for %d ticks, %d writes.",
+       READER_CNT, HOLD_CNT, HOLD_TICKS, WRITE_CNT);
+  rw_ticks = run_bench (&b, true);
+  rw_max = b.max_inside;
+  lock_ticks = run_bench (&b, false);
+
+  if (rw_max < 2)
+    fail ("readers never held the rwlock at the same time");
+  msg ("rwlock: %"PRId64" ticks, up to %d readers at once.", rw_ticks, rw_max);
+  msg ("lock: %"PRId64" ticks, up to %d readers at once.",
+       lock_ticks, b.max_inside);
+}
+
+static int64_t
+run_bench (struct bench *b, bool use_rwlock) 
+{
+  int64_t start;
+  int i;
+
+  b->use_rwlock = use_rwlock;
+  rwlock_init (&b->rw);
+  lock_init (&b->lock);
+  b->value[0] = b->value[1] = 0;
+  b->inside = b->max_inside = 0;
+  sema_init (&b->done, 0);
+
+  start = timer_ticks ();
+  for (i = 0; i < READER_CNT; i++)
+    thread_create ("reader", PRI_DEFAULT, reader_thread, b);
+  thread_create ("writer", PRI_DEFAULT, writer_thread, b);
+  for (i = 0; i < READER_CNT + 1; i++)
+    sema_down (&b->done);
+  return timer_elapsed (start);
+}
+
+static void
+reader_thread (void *b_) 
+{
+  struct bench *b = b_;
+  int i;
+
+  for (i = 0; i < HOLD_CNT; i++) 
+    {
+      enum intr_level old_level;
+      int v0, v1;
+
+      if (b->use_rwlock)
+        rwlock_read_acquire (&b->rw);
+      else
+        lock_acquire (&b->lock);
+
+      old_level = intr_disable ();
+      if (++b->inside > b->max_inside)
+        b->max_inside = b->inside;
+      intr_set_level (old_level);
+
+      v0 = b->value[0];
+      timer_sleep (HOLD_TICKS);
+      v1 = b->value[1];
+      if (v0 != v1)
+        fail ("reader saw a torn write: %d, %d", v0, v1);
+
+      old_level = intr_disable ();
+      b->inside--;
+      intr_set_level (old_level);
+
+      if (b->use_rwlock)
+        rwlock_read_release (&b->rw);
+      else
+        lock_release (&b->lock);
+    }
+  sema_up (&b->done);
+}
+
+static void
+writer_thread (void *b_) 
+{
+  struct bench *b = b_;
+  int i;
+
+  for (i = 0; i < WRITE_CNT; i++) 
+    {
+      if (b->use_rwlock)
+        rwlock_write_acquire (&b->rw);
+      else
+        lock_acquire (&b->lock);
+
+      b->value[0]++;
+      thread_yield ();
+      b->value[1]++;
+
+      if (b->use_rwlock)
+        rwlock_write_release (&b->rw);
+      else
+        lock_release (&b->lock);
+      timer_sleep (HOLD_TICKS);
+    }
+  sema_up (&b->done);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+fail "missing rwlock timing in output\n"
+  unless grep (/rwlock: \d+ ticks, up to \d+ readers at once\./, @output);
+fail "missing lock timing in output\n"
+  unless grep (/\) lock: \d+ ticks, up to \d+ readers at once\./, @output);
+
+pass;
@@ -0,0 +1,95 @@
+/* Checks the slab allocator.  Objects of an awkward size must
+   come back aligned and must not overlap, the constructor must
+   run once per object rather than on every allocation, and a
+   page must hold more of them than malloc(), which rounds 200
+   bytes up to 256, can fit. */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+#include "threads/vaddr.h"
+
+#define OBJ_CNT 300
+#define REUSE_CNT 10
+#define CTOR_MAGIC 0x0b1ec7
+
+struct obj 
+  {
+    uint32_t magic;             /* CTOR_MAGIC while free. */
+    uint32_t idx;
+    uint8_t data[192];
+  };
+
+static struct obj *objs[OBJ_CNT];
+static int ctor_cnt;
+
+static void
+obj_ctor (void *obj_) 
+{
+  struct obj *obj = obj_;
+
+  obj->magic = CTOR_MAGIC;
+  ctor_cnt++;
+}
+
+void
+test_slab_cache (void) 
+{
+  struct kmem_cache *cache;
+  size_t per_slab;
+  int ctor_before;
+  int i, j;
+
+  cache = kmem_cache_create ("test", sizeof (struct obj), 16, obj_ctor);
+  if (cache == NULL)
+    fail ("kmem_cache_create failed");
+  per_slab = kmem_cache_objs_per_slab (cache);
+  if (per_slab <= PGSIZE / 256)
+    fail ("only %zu objects per slab", per_slab);
+  msg ("%zu-byte objects: more per page than malloc.", sizeof (struct obj));
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      struct obj *obj = objs[i] = kmem_cache_alloc (cache);
+      if (obj == NULL)
+        fail ("allocation %d failed", i);
+      if ((uintptr_t) obj % 16 != 0)
+        fail ("object %d at %p is misaligned", i, obj);
+      if (obj->magic != CTOR_MAGIC)
+        fail ("object %d was not constructed", i);
+      obj->magic = 0;
+      obj->idx = i;
+      for (j = 0; j < (int) sizeof obj->data; j++)
+        obj->data[j] = i;
+    }
+  for (i = 0; i < OBJ_CNT; i++) 
+    for (j = 0; j < (int) sizeof objs[i]->data; j++)
+      if (objs[i]->idx != (uint32_t) i || objs[i]->data[j] != (uint8_t) i)
+        fail ("object %d was overwritten", i);
+  msg ("%d objects allocated without overlap.", OBJ_CNT);
+
+  /* Freed objects are reused as they are. */
+  ctor_before = ctor_cnt;
+  for (i = 0; i < REUSE_CNT; i++) 
+    {
+      objs[i]->magic = CTOR_MAGIC;
+      kmem_cache_free (cache, objs[i]);
+    }
+  for (i = 0; i < REUSE_CNT; i++) 
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL || objs[i]->magic != CTOR_MAGIC)
+        fail ("reused object %d is not in its constructed state", i);
+    }
+  if (ctor_cnt != ctor_before)
+    fail ("constructor ran %d more times", ctor_cnt - ctor_before);
+  msg ("freed objects reused without reconstruction.");
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i]->magic = CTOR_MAGIC;
+      kmem_cache_free (cache, objs[i]);
+    }
+  kmem_cache_destroy (cache);
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) 200-byte objects: more per page than malloc.
+(slab-cache) 300 objects allocated without overlap.
+(slab-cache) freed objects reused without reconstruction.
+(slab-cache) end
+EOF
+pass;
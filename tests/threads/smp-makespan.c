@@ -0,0 +1,99 @@
+/* Measures the makespan of THREAD_CNT CPU-bound threads, that is,
+   the time from creating the first one until the last one
+   finishes.  The same amount of work is first timed on a single
+   thread, so the output shows how close the scheduler gets to
+   perfect scaling over the CPUs that run threads.
+
+   Run with "pintos --smp M" to vary the number of cores.  Only
+   the CPUs that came online count.  This is a benchmark: it only
+   fails if a thread does not finish. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/cpu.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8
+#define SPIN_CNT 4000000
+
+struct spin_info 
+  {
+    int id;                     /* Thread number. */
+    int64_t start;              /* Time the batch was started. */
+    int64_t finish;             /* Ticks after START it finished. */
+    struct semaphore *done;     /* Upped when finished. */
+  };
+
+static thread_func spin_thread;
+static void spin (void);
+
+void
+test_smp_makespan (void) 
+{
+  struct spin_info info[THREAD_CNT];
+  struct semaphore done;
+  int64_t start, single, makespan;
+  int cpu_online = 0;
+  int i;
+
+  for (i = 0; i < cpu_cnt; i++)
+    if (cpus[i].online)
+      cpu_online++;
+
+  /* Time one unit of work on its own. */
+  start = timer_ticks ();
+  spin ();
+  single = timer_elapsed (start);
+
+  msg ("%d CPU-bound threads on %d CPU(s).", THREAD_CNT, cpu_online);
+  sema_init (&done, 0);
+  start = timer_ticks ();
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      char name[16];
+
+      info[i].id = i;
+      info[i].start = start;
+      info[i].finish = -1;
+      info[i].done = &done;
+      snprintf (name, sizeof name, "spin %d", i);
+      thread_create (name, PRI_DEFAULT, spin_thread, &info[i]);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+  makespan = timer_elapsed (start);
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      if (info[i].finish < 0)
+        fail ("thread %d did not finish", i);
+      msg ("thread %d finished after %"PRId64" ticks.", i, info[i].finish);
+    }
+  msg ("single thread: %"PRId64" ticks.", single);
+  msg ("makespan: %"PRId64" ticks (perfect scaling: %"PRId64" ticks).",
+       makespan, single * THREAD_CNT / cpu_online);
+}
+
+static void
+spin_thread (void *info_) 
+{
+  struct spin_info *info = info_;
+
+  spin ();
+  info->finish = timer_elapsed (info->start);
+  sema_up (info->done);
+}
+
+/* One unit of CPU-bound work. */
+static void
+spin (void) 
+{
+  volatile int i;
+
+  for (i = 0; i < SPIN_CNT; i++)
+    continue;
+}
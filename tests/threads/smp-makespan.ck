@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+my ($thread_cnt) = 8;
+my (@finished) = grep (/thread \d+ finished after \d+ ticks/, @output);
+fail "expected $thread_cnt threads to finish but "
+  . scalar (@finished) . " did\n"
+  if @finished != $thread_cnt;
+fail "missing makespan in output\n"
+  unless grep (/makespan: \d+ ticks/, @output);
+
+pass;
@@ -0,0 +1,83 @@
+/* Measures how fast two threads can hand the CPU back and forth
+   through a pair of semaphores, once with the lean switch of
+   switch.S and once with the full intr_frame save that
+   thread_launch() used before.  Every round trip is two context
+   switches.  This is a benchmark: it only fails if the partner
+   thread does not see every round. */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define ROUND_CNT 100000
+
+struct pingpong 
+  {
+    struct semaphore ping;
+    struct semaphore pong;
+    int rounds;
+  };
+
+static thread_func partner_thread;
+static void run_bench (const char *name, bool full);
+
+void
+test_switch_bench (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("%d round trips between two threads.", ROUND_CNT);
+  run_bench ("lean", false);
+  run_bench ("iret", true);
+}
+
+static void
+run_bench (const char *name, bool full) 
+{
+  struct pingpong pp;
+  int64_t start, elapsed;
+  int i;
+
+  sema_init (&pp.ping, 0);
+  sema_init (&pp.pong, 0);
+  pp.rounds = 0;
+  thread_create ("partner", PRI_DEFAULT, partner_thread, &pp);
+
+  thread_switch_full = full;
+  start = timer_ns ();
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_up (&pp.ping);
+      sema_down (&pp.pong);
+    }
+  elapsed = timer_ns () - start;
+  thread_switch_full = false;
+
+  if (pp.rounds != ROUND_CNT)
+    fail ("%s: partner saw %d rounds, expected %d", name, pp.rounds,
+          ROUND_CNT);
+  if (elapsed <= 0)
+    elapsed = 1;
+  msg ("%s: %"PRId64" switches per second, %"PRId64" ns per switch.",
+       name, 2 * ROUND_CNT * (int64_t) 1000000000 / elapsed,
+       elapsed / (2 * ROUND_CNT));
+}
+
+static void
+partner_thread (void *pp_) 
+{
+  struct pingpong *pp = pp_;
+  int i;
+
+  for (i = 0; i < ROUND_CNT; i++) 
+    {
+      sema_down (&pp->ping);
+      pp->rounds++;
+      sema_up (&pp->pong);
+    }
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+foreach my $name ('lean', 'iret') {
+    fail "missing timings for $name\n"
+      unless grep (/\) $name: \d+ switches per second, \d+ ns per switch\./, @output);
+}
+
+pass;
@@ -17,6 +17,7 @@ static const struct test tests[] =
     {"alarm-priority", test_alarm_priority},
     {"alarm-zero", test_alarm_zero},
     {"alarm-negative", test_alarm_negative},
+    {"alarm-timeout", test_alarm_timeout},
     {"priority-change", test_priority_change},
     {"priority-donate-one", test_priority_donate_one},
     {"priority-donate-multiple", test_priority_donate_multiple},
@@ -25,10 +26,23 @@ static const struct test tests[] =
     {"priority-donate-sema", test_priority_donate_sema},
     {"priority-donate-lower", test_priority_donate_lower},
     {"priority-donate-chain", test_priority_donate_chain},
+    {"priority-donate-chain-bench", test_priority_donate_chain_bench},
     {"priority-fifo", test_priority_fifo},
     {"priority-preempt", test_priority_preempt},
     {"priority-sema", test_priority_sema},
     {"priority-condvar", test_priority_condvar},
+    {"smp-makespan", test_smp_makespan},
+    {"lock-contention-bench", test_lock_contention_bench},
+    {"priority-donate-rwlock", test_priority_donate_rwlock},
+    {"rwlock-read-bench", test_rwlock_read_bench},
+    {"rcu-list", test_rcu_list},
+    {"priority-condvar-broadcast", test_priority_condvar_broadcast},
+    {"deadline-edf", test_deadline_edf},
+    {"thread-stats", test_thread_stats},
+    {"switch-bench", test_switch_bench},
+    {"palloc-buddy", test_palloc_buddy},
+    {"slab-cache", test_slab_cache},
+    {"malloc-churn", test_malloc_churn},
     {"mlfqs-load-1", test_mlfqs_load_1},
     {"mlfqs-load-60", test_mlfqs_load_60},
     {"mlfqs-load-avg", test_mlfqs_load_avg},
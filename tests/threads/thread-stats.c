@@ -0,0 +1,57 @@
+/* Tests per-thread accounting.  A thread that sleeps on a lock
+   for several ticks must see that time in lock_ns and count the
+   switch as voluntary. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func waiter;
+
+static struct lock lock;
+static struct thread_stats waiter_stats;
+
+void
+test_thread_stats (void) 
+{
+  struct thread_stats st;
+  int64_t min_ns = 4 * (NSEC_PER_SEC / TIMER_FREQ);
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  lock_init (&lock);
+  lock_acquire (&lock);
+  thread_create ("waiter", PRI_DEFAULT + 1, waiter, NULL);
+  timer_sleep (5);
+  lock_release (&lock);
+
+  if (waiter_stats.lock_ns < min_ns)
+    fail ("waiter slept %lld ns on the lock, expected at least %lld",
+          waiter_stats.lock_ns, min_ns);
+  if (waiter_stats.voluntary < 1)
+    fail ("waiter's switches were not counted as voluntary");
+  if (waiter_stats.dispatches < 2)
+    fail ("waiter dispatched %llu times", waiter_stats.dispatches);
+  msg ("Waiter's lock wait accounted.");
+
+  if (!thread_get_stats (0, &st) || st.run_ns <= 0)
+    fail ("no run time for the running thread");
+  if (st.voluntary < 1)
+    fail ("timer_sleep() was not counted as voluntary");
+  msg ("Main thread's run time accounted.");
+
+  if (thread_get_stats (TID_ERROR, &st))
+    fail ("found statistics for a bad tid");
+}
+
+static void
+waiter (void *aux UNUSED) 
+{
+  lock_acquire (&lock);
+  thread_get_stats (0, &waiter_stats);
+  lock_release (&lock);
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-stats) begin
+(thread-stats) Waiter's lock wait accounted.
+(thread-stats) Main thread's run time accounted.
+(thread-stats) end
+EOF
+pass;
@@ -0,0 +1,395 @@
+#include "threads/cpu.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/loader.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/rcu.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* Multiprocessor support.
+
+   This finds and starts the other CPUs, which then run threads
+   like the BSP, cpu0: each from its own run queue, stealing from
+   the others when it runs dry (see thread.c).  Kernel code still
+   excludes other CPUs only by turning interrupts off, which the
+   big kernel lock of interrupt.c makes work across CPUs.  User
+   processes stay on cpu0, whose TSS and syscall entry they use.
+
+   Only the BSP gets the 8254 timer interrupt, which keeps the
+   time.  The APs are ticked by their local APIC timers,
+   calibrated against the BSP's, and woken from their idle loop
+   by cpu_kick() when a thread becomes ready for them.
+
+   CPUs are discovered through the MP configuration table that
+   the BIOS leaves in low memory (see the Intel MultiProcessor
+   Specification, version 1.4), and each AP is started with the
+   INIT-SIPI-SIPI sequence sent through the BSP's local APIC.
+
+   An AP starts in real mode at the trampoline in mpentry.S,
+   which cpu_start_aps() copies to LOADER_MPENTRY.  The
+   trampoline switches straight to long mode on the boot page
+   table of start.S and then calls ap_main() on a stack that was
+   prepared for it here. */
+
+struct cpu cpus[CPU_MAX];
+int cpu_cnt = 1;
+int cpu_online_cnt = 1;
+
+/* MP floating pointer structure. */
+struct mp_fp {
+	uint8_t signature[4];   /* "_MP_" */
+	uint32_t physaddr;      /* Physical address of the config table. */
+	uint8_t length;         /* In 16-byte units, 1. */
+	uint8_t specrev;        /* 1 or 4. */
+	uint8_t checksum;       /* All bytes must add up to 0. */
+	uint8_t type;           /* Default configuration type, 0 if none. */
+	uint8_t imcrp;
+	uint8_t reserved[3];
+} __attribute__((packed));
+
+/* MP configuration table header. */
+struct mp_conf {
+	uint8_t signature[4];   /* "PCMP" */
+	uint16_t length;        /* Total table length. */
+	uint8_t version;
+	uint8_t checksum;       /* All bytes must add up to 0. */
+	uint8_t product[20];
+	uint32_t oemtable;
+	uint16_t oemlength;
+	uint16_t entry;         /* Number of entries that follow. */
+	uint32_t lapicaddr;     /* Physical address of the local APIC. */
+	uint16_t xlength;
+	uint8_t xchecksum;
+	uint8_t reserved;
+} __attribute__((packed));
+
+/* MP configuration table processor entry. */
+struct mp_proc {
+	uint8_t type;           /* MP_PROC. */
+	uint8_t apicid;         /* Local APIC ID. */
+	uint8_t version;
+	uint8_t flags;          /* MP_PROC_*. */
+	uint8_t signature[4];
+	uint32_t feature;
+	uint8_t reserved[8];
+} __attribute__((packed));
+
+/* MP configuration table entry types.  Only processor entries
+   are 20 bytes long; all the others are 8. */
+#define MP_PROC    0x00
+#define MP_BUS     0x01
+#define MP_IOAPIC  0x02
+#define MP_IOINTR  0x03
+#define MP_LINTR   0x04
+
+#define MP_PROC_EN   0x01       /* Processor is usable. */
+#define MP_PROC_BP   0x02       /* Processor is the BSP. */
+
+/* Local APIC registers, as byte offsets. */
+#define LAPIC_ID     0x020      /* ID. */
+#define LAPIC_EOI    0x0b0      /* End of interrupt. */
+#define LAPIC_SVR    0x0f0      /* Spurious interrupt vector. */
+#define LAPIC_ICRLO  0x300      /* Interrupt command, bits 0-31. */
+#define LAPIC_ICRHI  0x310      /* Interrupt command, bits 32-63. */
+#define LAPIC_TIMER  0x320      /* Local vector table, timer. */
+#define LAPIC_TICR   0x380      /* Timer initial count. */
+#define LAPIC_TCCR   0x390      /* Timer current count. */
+#define LAPIC_TDCR   0x3e0      /* Timer divide configuration. */
+
+#define SVR_ENABLE   0x00000100 /* APIC software enable. */
+#define LVT_MASKED   0x00010000 /* Interrupt masked. */
+#define LVT_PERIODIC 0x00020000 /* Timer reloads itself. */
+#define TDCR_16      0x3        /* Timer counts bus clock / 16. */
+
+/* Vectors of the local APIC interrupts. */
+#define VEC_TIMER    0xf0       /* Local APIC timer. */
+#define VEC_KICK     0xf1       /* cpu_kick(). */
+#define VEC_SPURIOUS 0xff       /* Spurious, needs no EOI. */
+
+/* Interrupt command register bits. */
+#define ICR_INIT     0x00000500 /* INIT IPI. */
+#define ICR_STARTUP  0x00000600 /* Startup IPI. */
+#define ICR_PENDING  0x00001000 /* Delivery status. */
+#define ICR_ASSERT   0x00004000 /* Assert interrupt (vs. deassert). */
+#define ICR_LEVEL    0x00008000 /* Level triggered. */
+
+/* Local APIC, mapped by cpu_init() if there is more than one CPU. */
+static volatile uint32_t *lapic;
+
+/* Local APIC timer counts per timer tick. */
+static uint32_t lapic_ticks;
+
+/* Handed from cpu_start_aps() to the AP that is being started.
+   Read by mpentry.S. */
+uint64_t mpentry_cr3;
+uint64_t mpentry_stack;
+static struct cpu *mpentry_cpu;
+
+/* Global descriptor table for the APs.  Same as the temporal gdt
+   of thread.c; the trampoline's copy lives in low memory. */
+static uint64_t ap_gdt[3] = {0, 0x00af9a000000ffff, 0x00cf92000000ffff};
+
+/* Boundaries of the trampoline in mpentry.S. */
+extern uint8_t mpentry_start[], mpentry_end[];
+
+void ap_main (void) NO_RETURN;
+
+static uint8_t
+sum (const uint8_t *p, size_t len) {
+	uint8_t s = 0;
+	while (len-- > 0)
+		s += *p++;
+	return s;
+}
+
+/* Looks for an MP floating pointer structure in the LEN bytes
+   starting at physical address PA. */
+static struct mp_fp *
+mp_search (uint64_t pa, size_t len) {
+	uint8_t *p = ptov (pa);
+	uint8_t *end = p + len;
+
+	for (; p < end; p += sizeof (struct mp_fp))
+		if (!memcmp (p, "_MP_", 4) && sum (p, sizeof (struct mp_fp)) == 0)
+			return (struct mp_fp *) p;
+	return NULL;
+}
+
+/* Finds the MP configuration table, or returns NULL if the BIOS
+   did not provide one.
+
+   The specification also allows the first KB of the EBDA, whose
+   segment is stored at 0x40e in the BIOS data area, but that
+   area lies inside the initial thread's page and has already
+   been overwritten by the time we get here.  QEMU's BIOS keeps
+   the structure in the BIOS ROM, and the last KB of base memory
+   covers a default-sized EBDA. */
+static struct mp_conf *
+mp_config (void) {
+	struct mp_fp *fp;
+	struct mp_conf *conf;
+
+	fp = mp_search (0x9fc00, 0x400);
+	if (fp == NULL)
+		fp = mp_search (0xf0000, 0x10000);
+	if (fp == NULL || fp->physaddr == 0)
+		return NULL;
+
+	conf = ptov (fp->physaddr);
+	if (memcmp (conf, "PCMP", 4) || (conf->version != 1 && conf->version != 4)
+			|| sum ((uint8_t *) conf, conf->length) != 0)
+		return NULL;
+	return conf;
+}
+
+/* Maps the local APIC registers at physical address PA into the
+   kernel's address space, uncached. */
+static void
+lapic_map (uint64_t pa) {
+	uint64_t va = (uint64_t) ptov (pa);
+	uint64_t *pte = pml4e_walk (base_pml4, va, 1);
+
+	if (pte == NULL)
+		PANIC ("cpu: cannot map local APIC");
+	*pte = pa | PTE_P | PTE_W | PTE_PWT | PTE_PCD;
+	invlpg (va);
+	lapic = (uint32_t *) va;
+}
+
+static uint32_t
+lapic_read (int reg) {
+	return lapic[reg / 4];
+}
+
+static void
+lapic_write (int reg, uint32_t value) {
+	lapic[reg / 4] = value;
+	lapic_read (LAPIC_ID);        /* Wait for the write to finish. */
+}
+
+/* Sends the interprocessor interrupt LO to the CPU whose local
+   APIC ID is APICID, and waits for it to be delivered. */
+static void
+lapic_ipi (uint8_t apicid, uint32_t lo) {
+	lapic_write (LAPIC_ICRHI, (uint32_t) apicid << 24);
+	lapic_write (LAPIC_ICRLO, lo);
+	while (lapic_read (LAPIC_ICRLO) & ICR_PENDING)
+		cpu_relax ();
+}
+
+/* Measures how many counts of the local APIC timer, divided by
+   16, make one timer tick.  Run on the BSP; the local APIC timers
+   of all CPUs count the same bus clock. */
+static void
+lapic_calibrate (void) {
+	int64_t start, ns;
+	uint32_t count;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	lapic_write (LAPIC_TDCR, TDCR_16);
+	lapic_write (LAPIC_TIMER, LVT_MASKED);
+	start = timer_ns ();
+	lapic_write (LAPIC_TICR, 0xffffffff);
+	timer_msleep (1000 / TIMER_FREQ);
+	count = 0xffffffff - lapic_read (LAPIC_TCCR);
+	ns = timer_ns () - start;
+	lapic_write (LAPIC_TICR, 0);
+
+	lapic_ticks = (uint64_t) count * (NSEC_PER_SEC / TIMER_FREQ) / ns;
+	if (lapic_ticks == 0)
+		lapic_ticks = 1;
+}
+
+/* Local APIC timer interrupt of an AP. */
+static void
+lapic_timer_interrupt (struct intr_frame *args UNUSED) {
+	lapic_write (LAPIC_EOI, 0);
+	timer_tick_ap ();
+}
+
+/* Interprocessor interrupt of cpu_kick().  Waking the CPU up is
+   all it has to do: the idle loop then looks for work. */
+static void
+kick_interrupt (struct intr_frame *args UNUSED) {
+	lapic_write (LAPIC_EOI, 0);
+}
+
+/* Finds the CPUs in the system.  Must be called after
+   paging_init(), with cpus[0] already set up by thread_init().
+
+   시스템의 CPU들을 찾는다.  MP 테이블이 없으면 BSP 하나로 동작한다. */
+void
+cpu_init (void) {
+	struct mp_conf *conf;
+	uint8_t *p, *end;
+	int i;
+
+	conf = mp_config ();
+	if (conf == NULL)
+		return;
+
+	p = (uint8_t *) (conf + 1);
+	end = (uint8_t *) conf + conf->length;
+	for (i = 0; i < conf->entry && p < end; i++) {
+		struct mp_proc *proc = (struct mp_proc *) p;
+
+		if (*p != MP_PROC) {
+			p += 8;
+			continue;
+		}
+		p += sizeof *proc;
+
+		if (!(proc->flags & MP_PROC_EN))
+			continue;
+		if (proc->flags & MP_PROC_BP)
+			cpus[0].lapic_id = proc->apicid;
+		else if (cpu_cnt < CPU_MAX) {
+			struct cpu *c = &cpus[cpu_cnt];
+			c->id = cpu_cnt++;
+			c->lapic_id = proc->apicid;
+			thread_init_cpu (c);
+		}
+	}
+
+	if (cpu_cnt > 1)
+		lapic_map (conf->lapicaddr);
+}
+
+/* Starts the APs found by cpu_init(), one at a time.  Must be
+   called after timer_calibrate(), since the startup protocol
+   needs short delays, and with interrupts on.
+
+   Each AP comes up on its own idle thread, which then runs the
+   AP's share of the threads. */
+void
+cpu_start_aps (void) {
+	struct cpu *c;
+
+	if (cpu_cnt == 1)
+		return;
+
+	intr_register_local (VEC_TIMER, lapic_timer_interrupt, "LAPIC Timer");
+	intr_register_local (VEC_KICK, kick_interrupt, "Kick IPI");
+	lapic_write (LAPIC_SVR, SVR_ENABLE | VEC_SPURIOUS);
+	lapic_calibrate ();
+	intr_lock_init ();
+
+	memcpy (ptov (LOADER_MPENTRY), mpentry_start, mpentry_end - mpentry_start);
+	mpentry_cr3 = vtop (base_pml4);
+
+	for (c = cpus + 1; c < cpus + cpu_cnt; c++) {
+		struct thread *idle = thread_create_idle (c);
+		int ms;
+
+		if (idle == NULL)
+			PANIC ("cpu%d: out of memory", c->id);
+		mpentry_stack = (uint64_t) idle + PGSIZE;
+		mpentry_cpu = c;
+
+		/* Universal startup algorithm, [MP] B.4. */
+		lapic_ipi (c->lapic_id, ICR_INIT | ICR_LEVEL | ICR_ASSERT);
+		timer_usleep (200);
+		lapic_ipi (c->lapic_id, ICR_INIT | ICR_LEVEL);
+		timer_msleep (10);
+		for (int i = 0; i < 2 && !c->started; i++) {
+			lapic_ipi (c->lapic_id, ICR_STARTUP | (LOADER_MPENTRY >> PGBITS));
+			timer_usleep (200);
+		}
+
+		for (ms = 0; ms < 100 && !c->started; ms++)
+			timer_msleep (1);
+		if (!c->started)
+			printf ("cpu%d: did not start\n", c->id);
+	}
+	printf ("%d of %d CPUs started.\n", cpu_online_cnt, cpu_cnt);
+}
+
+/* Wakes up C if it is halted in its idle thread, so that it
+   looks for threads to run. */
+void
+cpu_kick (struct cpu *c) {
+	ASSERT (c->online);
+	ASSERT (c != cpu_current ());
+
+	lapic_ipi (c->lapic_id, ICR_ASSERT | VEC_KICK);
+}
+
+/* Returns the CPU that the caller is running on, which is the
+   one the running thread belongs to. */
+struct cpu *
+cpu_current (void) {
+	struct thread *t = (struct thread *) pg_round_down (rrsp ());
+	return t->cpu;
+}
+
+/* Entry point of an AP in C, called by mpentry.S on the stack of
+   the AP's idle thread with the kernel page table active.  Sets
+   up the CPU, brings it online and becomes its idle thread. */
+void
+ap_main (void) {
+	struct cpu *c = mpentry_cpu;
+	struct desc_ptr gdt_ds = {
+		.size = sizeof (ap_gdt) - 1,
+		.address = (uint64_t) ap_gdt};
+
+	lgdt (&gdt_ds);
+	intr_init_ap ();
+
+	lapic_write (LAPIC_SVR, SVR_ENABLE | VEC_SPURIOUS);
+	lapic_write (LAPIC_TDCR, TDCR_16);
+	lapic_write (LAPIC_TIMER, LVT_PERIODIC | VEC_TIMER);
+	lapic_write (LAPIC_TICR, lapic_ticks);
+
+	rcu_cpu_online (c);
+	c->online = true;
+	cpu_online_cnt++;
+	c->started = true;
+	thread_start_ap (c);
+}
@@ -13,17 +13,22 @@
 #include "devices/serial.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/lockstat.h"
 #include "threads/loader.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/rcu.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #include "userprog/exception.h"
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -80,12 +85,15 @@ main (void) {
 	/* Initialize ourselves as a thread so we can use locks,
 	   then enable console locking. */
 	thread_init ();
+	rcu_init ();
 	console_init ();
 
 	/* Initialize memory system. */
 	mem_end = palloc_init ();
 	malloc_init ();
+	kmem_cache_init ();
 	paging_init (mem_end);
+	cpu_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -100,11 +108,15 @@ main (void) {
 #ifdef USERPROG
 	exception_init ();
 	syscall_init ();
+	fpu_init ();
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	rcu_start ();
+	palloc_start ();
 	serial_init_queue ();
 	timer_calibrate ();
+	cpu_start_aps ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -252,6 +264,18 @@ run_task (char **argv) {
 	printf ("Execution of '%s' complete.\n", task);
 }
 
+/* Prints per-thread CPU and scheduling statistics. */
+static void
+print_threads (char **argv UNUSED) {
+	thread_print_all_stats ();
+}
+
+/* Prints the lock contention profile. */
+static void
+print_lockstat (char **argv UNUSED) {
+	lockstat_print ();
+}
+
 /* Executes all of the actions specified in ARGV[]
    up to the null pointer sentinel. */
 static void
@@ -266,6 +290,8 @@ run_actions (char **argv) {
 	/* Table of supported actions. */
 	static const struct action actions[] = {
 		{"run", 2, run_task},
+		{"ps", 1, print_threads},
+		{"lockstat", 1, print_lockstat},
 #ifdef FILESYS
 		{"ls", 1, fsutil_ls},
 		{"cat", 2, fsutil_cat},
@@ -312,6 +338,8 @@ usage (void) {
 #else
 			"  run TEST           Run TEST.\n"
 #endif
+			"  ps                 Print statistics of every thread.\n"
+			"  lockstat           Print lock contention (make LOCKSTAT=1).\n"
 #ifdef FILESYS
 			"  ls                 List files in the root directory.\n"
 			"  cat FILE           Print FILE to the console.\n"
@@ -354,6 +382,7 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	kmem_cache_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -362,4 +391,7 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef LOCKSTAT
+	lockstat_print ();
+#endif
 }
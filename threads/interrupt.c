@@ -3,6 +3,7 @@
 #include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/intr-stubs.h"
 #include "threads/io.h"
@@ -13,6 +14,7 @@
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
+#include "userprog/process.h"
 #endif
 
 /* Number of x86_64 interrupts. */
@@ -142,13 +144,33 @@ static const char *intr_names[INTR_CNT];
    외부 인터럽트의 핸들러도 슬립하면 안 되지만, 인터럽트가 반환하기 직전에 새로운 
    프로세스가 예약되도록 요청하기 위해 intr_yield_on_return()를 호출할 수 있습니다. */
 
-/* Are we processing an external interrupt? 
+/* Are we processing an external interrupt?  One flag per CPU.
    외부 인터럽트가 발생 중인가? */
-static bool in_external_intr;   
+static bool in_external_intr[CPU_MAX];
 
-/* Should we yield on interrupt return? 
+/* Should we yield on interrupt return?  One flag per CPU.
    우리가 인터럽트 반환값을 생성해야 하는가?*/
-static bool yield_on_return;   
+static bool yield_on_return[CPU_MAX];
+
+/* Big kernel lock.
+
+   All kernel code protects shared state by turning interrupts
+   off, which only excludes the local CPU.  Once the APs run
+   threads (see intr_lock_init()), a CPU therefore holds this
+   lock whenever its interrupts are off: intr_disable() takes it
+   and intr_enable() drops it, and the interrupt entry and exit
+   path does the same when it changes the interrupt flag.  Code
+   that runs with interrupts on, such as user programs and
+   compute-bound kernel threads, still runs on all CPUs at once.
+
+   A thread switch happens with interrupts off, so the lock
+   passes from the old thread to the new one.  New threads start
+   with interrupts off for that reason (see thread_create()). */
+static volatile int big_lock;
+static bool big_lock_on;
+
+/* Vectors of the local APIC interrupts, see intr_register_local(). */
+#define INTR_LOCAL_MIN 0xf0
 
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
@@ -157,6 +179,31 @@ static void pic_end_of_interrupt (int irq);
 /* Interrupt handlers. */
 void intr_handler (struct intr_frame *args);
 
+/* Index of the running CPU into the per-CPU flags.  Only cpu0
+   runs before the APs start, which may be before thread_init()
+   made cpu_current() usable. */
+static int
+this_cpu (void) {
+	return big_lock_on ? cpu_current ()->id : 0;
+}
+
+static void
+big_lock_acquire (void) {
+	if (!big_lock_on)
+		return;
+	while (__atomic_exchange_n (&big_lock, 1, __ATOMIC_ACQUIRE))
+		while (big_lock)
+			cpu_relax ();
+}
+
+static void
+big_lock_release (void) {
+	if (!big_lock_on)
+		return;
+	ASSERT (big_lock);
+	__atomic_store_n (&big_lock, 0, __ATOMIC_RELEASE);
+}
+
 /* Returns the current interrupt status. */
 enum intr_level
 intr_get_level (void) {
@@ -192,10 +239,13 @@ intr_enable (void) {
 	enum intr_level old_level = intr_get_level ();
 	ASSERT (!intr_context ());
 
+	if (old_level == INTR_OFF)
+		big_lock_release ();
+
 	/* Enable interrupts by setting the interrupt flag.
 	   See [IA32-v2b] "STI" and [IA32-v3a] 5.8.1 "Masking Maskable
 	   Hardware Interrupts". */
-	asm volatile ("sti");
+	asm volatile ("sti" : : : "memory");
 
 	return old_level;
 }
@@ -211,9 +261,38 @@ intr_disable (void) {
 	   Hardware Interrupts". */
 	asm volatile ("cli" : : : "memory");
 
+	if (old_level == INTR_ON)
+		big_lock_acquire ();
+
 	return old_level;
 }
 
+/* Enables interrupts and halts until the next one arrives.  The
+   caller must have interrupts off.
+
+   The `sti' instruction disables interrupts until the
+   completion of the next instruction, so `sti; hlt' is atomic:
+   an interrupt cannot slip in between and leave us halting with
+   nothing to wait for.  See [IA32-v2a] "HLT", [IA32-v2b] "STI",
+   and [IA32-v3a] 7.11.1 "HLT Instruction". */
+void
+intr_halt (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!intr_context ());
+
+	big_lock_release ();
+	asm volatile ("sti; hlt" : : : "memory");
+}
+
+/* Makes intr_disable() exclude the other CPUs too, by taking the
+   big kernel lock.  Called by cpu_start_aps() with interrupts on,
+   before the first AP starts. */
+void
+intr_lock_init (void) {
+	ASSERT (intr_get_level () == INTR_ON);
+	big_lock_on = true;
+}
+
 /* Initializes the interrupt system. */
 void
 intr_init (void) {
@@ -281,6 +360,17 @@ register_handler (uint8_t vec_no, int dpl, enum intr_level level,
 	intr_names[vec_no] = name;
 }
 
+/* Loads the IDT built by intr_init() on an application
+   processor.  The IDT is shared by all CPUs.  The AP runs with
+   interrupts off, so this also takes the big kernel lock. */
+void
+intr_init_ap (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	lidt(&idt_desc);
+	big_lock_acquire ();
+}
+
 /* Registers external interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The handler will
    execute with interrupts disabled. 
@@ -324,16 +414,30 @@ intr_register_int (uint8_t vec_no, int dpl, enum intr_level level,
 		intr_handler_func *handler, const char *name)
 {
 	ASSERT (vec_no < 0x20 || vec_no > 0x2f);
+	ASSERT (vec_no < INTR_LOCAL_MIN);
 	register_handler (vec_no, dpl, level, handler, name);
 }
 
+/* Registers local APIC interrupt VEC_NO, which must lie within
+   0xf0...0xff, to invoke HANDLER, which is named NAME for
+   debugging purposes.  Such interrupts, the local APIC timer and
+   interprocessor interrupts, are handled like external ones, but
+   HANDLER must send the end-of-interrupt to the local APIC
+   itself. */
+void
+intr_register_local (uint8_t vec_no, intr_handler_func *handler,
+		const char *name) {
+	ASSERT (vec_no >= INTR_LOCAL_MIN);
+	register_handler (vec_no, 0, INTR_OFF, handler, name);
+}
+
 /* Returns true during processing of an external interrupt
    and false at all other times. 
    외부 인터럽트 처리 중에는 true를 반환하고 
    다른 모든 시간에는 false를 반환합니다.*/
 bool
 intr_context (void) {
-	return in_external_intr;
+	return in_external_intr[this_cpu ()];
 }
 
 /* During processing of an external interrupt, directs the
@@ -347,7 +451,7 @@ intr_context (void) {
 void
 intr_yield_on_return (void) {
 	ASSERT (intr_context ());
-	yield_on_return = true;
+	yield_on_return[this_cpu ()] = true;
 }
 
 /* 8259A Programmable Interrupt Controller. */
@@ -431,8 +535,14 @@ pic_end_of_interrupt (int irq) {
 
 void
 intr_handler (struct intr_frame *frame) {
-	bool external;
+	bool external, local;
 	intr_handler_func *handler;
+	int cpu;
+
+	/* An interrupt gate turned interrupts off on the way in. */
+	if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+		big_lock_acquire ();
+	cpu = this_cpu ();
 
 	/* External interrupts are special.
 	   We only handle one at a time (so interrupts must be off)
@@ -444,13 +554,17 @@ intr_handler (struct intr_frame *frame) {
        그리고 PIC에서 인터럽트를 인식해야 합니다 (아래 참조).
        외부 인터럽트 핸들러는 슬립할 수 없습니다.
 	    */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	local = frame->vec_no >= INTR_LOCAL_MIN;
+	external = (frame->vec_no >= 0x20 && frame->vec_no < 0x30) || local;
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
 
-		in_external_intr = true;
-		yield_on_return = false;
+		in_external_intr[cpu] = true;
+		yield_on_return[cpu] = false;
+
+		/* 유휴 중 건너뛴 타이머 틱을 먼저 처리한다. */
+		timer_idle_exit ();
 	}
 
 	/* Invoke the interrupt's handler. 
@@ -459,7 +573,7 @@ intr_handler (struct intr_frame *frame) {
 	if (handler != NULL){
 		handler (frame);
 	}
-	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f) {
+	else if (frame->vec_no == 0x27 || frame->vec_no == 0x2f || local) {
 		/* There is no handler, but this interrupt can trigger
 		   spuriously due to a hardware fault or hardware race
 		   condition.  Ignore it. 
@@ -481,13 +595,32 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (intr_context ());
 
-		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		in_external_intr[cpu] = false;
+		if (!local)
+			pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return){
+		if (yield_on_return[cpu]){
 			thread_yield ();
 		}
 	}
+
+#ifdef USERPROG
+	/* A user thread whose process is exiting must not go back to
+	   user mode, where it might spin forever.  Interrupts are off
+	   after an external interrupt; iretq would turn them on again
+	   anyway.
+	   프로세스가 끝나는 중이면 사용자 모드로 돌아가지 않고 끝낸다. */
+	if (frame->cs == SEL_UCSEG && thread_current ()->uthread != NULL
+			&& thread_current ()->leader->exiting) {
+		intr_enable ();
+		process_check_exit ();
+	}
+#endif
+
+	/* iretq turns interrupts back on, so let the other CPUs in.
+	   The handler may have done so already. */
+	if ((frame->eflags & FLAG_IF) && intr_get_level () == INTR_OFF)
+		big_lock_release ();
 }
 
 /* Dumps interrupt frame F to the console, for debugging. 
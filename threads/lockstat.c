@@ -0,0 +1,83 @@
+#include "threads/lockstat.h"
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+
+#ifdef LOCKSTAT
+
+/* Lockstat entries.  Locks are created at a few dozen places at
+   most, so a small table searched linearly is enough; further
+   sites share the last, catch-all entry. */
+#define LOCKSTAT_MAX 64
+static struct lockstat stats[LOCKSTAT_MAX];
+static int stat_cnt;
+static struct lockstat other = {.name = "(other)"};
+
+/* 이름이 NAME인 (NAME이 NULL이면 SITE에서 만든 이름 없는) 항목.
+   없으면 새로 만든다. */
+static struct lockstat *
+lockstat_find (const char *name, void *site) {
+	enum intr_level old_level = intr_disable ();
+	struct lockstat *s = &other;
+	int i;
+
+	for (i = 0; i < stat_cnt; i++)
+		if (name != NULL ? stats[i].name != NULL && !strcmp (stats[i].name, name)
+				: stats[i].name == NULL && stats[i].site == site) {
+			s = &stats[i];
+			break;
+		}
+	if (i == stat_cnt && stat_cnt < LOCKSTAT_MAX) {
+		s = &stats[stat_cnt++];
+		s->name = name;
+		s->site = site;
+	}
+	intr_set_level (old_level);
+	return s;
+}
+
+/* Returns the entry for unnamed locks initialized at SITE, the
+   return address of lock_init(). */
+struct lockstat *
+lockstat_site (void *site) {
+	return lockstat_find (NULL, site);
+}
+
+/* Returns the entry for locks named NAME, which must be a string
+   that lives forever. */
+struct lockstat *
+lockstat_named (const char *name) {
+	return lockstat_find (name, NULL);
+}
+
+/* Prints every entry that has been acquired at least once.
+   Unnamed sites are printed as code addresses, which the
+   `backtrace' tool turns into file and line. */
+void
+lockstat_print (void) {
+	int i;
+
+	printf ("Lockstat: %-20s %10s %10s %16s %16s\n",
+			"LOCK", "ACQUIRED", "CONTENDED", "WAIT(cycles)", "HOLDMAX(cycles)");
+	for (i = 0; i <= stat_cnt; i++) {
+		struct lockstat *s = i < stat_cnt ? &stats[i] : &other;
+		char site[24];
+
+		if (s->acquired == 0)
+			continue;
+		if (s->name == NULL)
+			snprintf (site, sizeof site, "%p", s->site);
+		printf ("Lockstat: %-20s %10llu %10llu %16llu %16llu\n",
+				s->name != NULL ? s->name : site, s->acquired, s->contended,
+				s->wait_cycles, s->hold_max_cycles);
+	}
+}
+
+#else /* !LOCKSTAT */
+
+void
+lockstat_print (void) {
+	printf ("Lockstat: not built in (make LOCKSTAT=1).\n");
+}
+
+#endif /* LOCKSTAT */
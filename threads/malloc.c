@@ -13,20 +13,25 @@
 
    The size of each request, in bytes, is rounded up to a power
    of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
-   the free list is nonempty, one of its blocks is used to
-   satisfy the request.
-
-   Otherwise, a new page of memory, called an "arena", is
-   obtained from the page allocator (if none is available,
-   malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
-
-   When we free a block, we add it to its descriptor's free list.
-   But if the arena that the block was in now has no in-use
-   blocks, we remove all of the arena's blocks from the free list
-   and give the arena back to the page allocator.
+   that size, found through the size_to_desc table.  Blocks come
+   from pages of memory called "arenas", each of which keeps its
+   own list of free blocks.  The descriptor keeps a list of the
+   arenas that have a free block, and the request is satisfied
+   from the first of them.
+
+   If there is no such arena, a new one is obtained from the page
+   allocator (if none is available, malloc() returns a null
+   pointer).  Its blocks are handed out in order, and only blocks
+   that have been freed go on its free list, so setting up an
+   arena does not touch every block.
+
+   When we free a block, we add it to its arena's free list.  If
+   the arena now has no in-use blocks and the descriptor has
+   another arena with free blocks, we give the arena back to the
+   page allocator; since the blocks are on the arena's own list,
+   that takes constant time.  The last such arena is kept, so
+   that a loop that allocates and frees one block does not get a
+   new page every time.
 
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
@@ -38,7 +43,7 @@
 struct desc {
 	size_t block_size;          /* Size of each element in bytes. */
 	size_t blocks_per_arena;    /* Number of blocks in an arena. */
-	struct list free_list;      /* List of free blocks. */
+	struct list arena_list;     /* Arenas with a free block. */
 	struct lock lock;           /* Lock. */
 };
 
@@ -50,6 +55,9 @@ struct arena {
 	unsigned magic;             /* Always set to ARENA_MAGIC. */
 	struct desc *desc;          /* Owning descriptor, null for big block. */
 	size_t free_cnt;            /* Free blocks; pages in big block. */
+	size_t carved_cnt;          /* Blocks handed out at least once. */
+	struct list free_list;      /* Freed blocks. */
+	struct list_elem elem;      /* Element in desc's arena_list. */
 };
 
 /* Free block. */
@@ -61,21 +69,38 @@ struct block {
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Smallest and largest block sizes. */
+#define MIN_BLOCK 16
+#define MAX_BLOCK (PGSIZE / 4)
+
+/* size_to_desc[DIV_ROUND_UP (SIZE, MIN_BLOCK)] is the descriptor
+   for a SIZE-byte request, for SIZE up to MAX_BLOCK. */
+static struct desc *size_to_desc[MAX_BLOCK / MIN_BLOCK + 1];
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void) {
-	size_t block_size;
+	size_t block_size, i;
+	struct desc *d;
 
-	for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2) {
-		struct desc *d = &descs[desc_cnt++];
+	for (block_size = MIN_BLOCK; block_size <= MAX_BLOCK; block_size *= 2) {
+		d = &descs[desc_cnt++];
 		ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
 		d->block_size = block_size;
 		d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
-		list_init (&d->free_list);
+		list_init (&d->arena_list);
 		lock_init (&d->lock);
+		lock_set_name (&d->lock, "malloc");
+	}
+
+	d = descs;
+	for (i = 0; i < sizeof size_to_desc / sizeof *size_to_desc; i++) {
+		while (d->block_size < i * MIN_BLOCK)
+			d++;
+		size_to_desc[i] = d;
 	}
 }
 
@@ -91,12 +116,7 @@ malloc (size_t size) {
 	if (size == 0)
 		return NULL;
 
-	/* Find the smallest descriptor that satisfies a SIZE-byte
-	   request. */
-	for (d = descs; d < descs + desc_cnt; d++)
-		if (d->block_size >= size)
-			break;
-	if (d == descs + desc_cnt) {
+	if (size > MAX_BLOCK) {
 		/* SIZE is too big for any descriptor.
 		   Allocate enough pages to hold SIZE plus an arena. */
 		size_t page_cnt = DIV_ROUND_UP (size + sizeof *a, PGSIZE);
@@ -112,12 +132,14 @@ malloc (size_t size) {
 		return a + 1;
 	}
 
-	lock_acquire (&d->lock);
+	/* Find the smallest descriptor that satisfies a SIZE-byte
+	   request. */
+	d = size_to_desc[DIV_ROUND_UP (size, MIN_BLOCK)];
 
-	/* If the free list is empty, create a new arena. */
-	if (list_empty (&d->free_list)) {
-		size_t i;
+	lock_acquire (&d->lock);
 
+	/* If no arena has a free block, create a new arena. */
+	if (list_empty (&d->arena_list)) {
 		/* Allocate a page. */
 		a = palloc_get_page (0);
 		if (a == NULL) {
@@ -125,20 +147,23 @@ malloc (size_t size) {
 			return NULL;
 		}
 
-		/* Initialize arena and add its blocks to the free list. */
+		/* Initialize arena.  Its blocks are carved out as needed. */
 		a->magic = ARENA_MAGIC;
 		a->desc = d;
 		a->free_cnt = d->blocks_per_arena;
-		for (i = 0; i < d->blocks_per_arena; i++) {
-			struct block *b = arena_to_block (a, i);
-			list_push_back (&d->free_list, &b->free_elem);
-		}
+		a->carved_cnt = 0;
+		list_init (&a->free_list);
+		list_push_front (&d->arena_list, &a->elem);
 	}
 
-	/* Get a block from free list and return it. */
-	b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-	a = block_to_arena (b);
-	a->free_cnt--;
+	/* Get a block from the first arena and return it. */
+	a = list_entry (list_front (&d->arena_list), struct arena, elem);
+	if (!list_empty (&a->free_list))
+		b = list_entry (list_pop_front (&a->free_list), struct block, free_elem);
+	else
+		b = arena_to_block (a, a->carved_cnt++);
+	if (--a->free_cnt == 0)
+		list_remove (&a->elem);
 	lock_release (&d->lock);
 	return b;
 }
@@ -215,18 +240,18 @@ free (void *p) {
 
 			lock_acquire (&d->lock);
 
-			/* Add block to free list. */
-			list_push_front (&d->free_list, &b->free_elem);
-
-			/* If the arena is now entirely unused, free it. */
-			if (++a->free_cnt >= d->blocks_per_arena) {
-				size_t i;
-
-				ASSERT (a->free_cnt == d->blocks_per_arena);
-				for (i = 0; i < d->blocks_per_arena; i++) {
-					struct block *b = arena_to_block (a, i);
-					list_remove (&b->free_elem);
-				}
+			/* Add block to its arena's free list. */
+			list_push_front (&a->free_list, &b->free_elem);
+			if (a->free_cnt++ == 0)
+				list_push_front (&d->arena_list, &a->elem);
+
+			/* If the arena is now entirely unused, free it, unless
+			   it is the descriptor's only arena with free blocks. */
+			ASSERT (a->free_cnt <= d->blocks_per_arena);
+			if (a->free_cnt == d->blocks_per_arena
+					&& list_front (&d->arena_list)
+						!= list_back (&d->arena_list)) {
+				list_remove (&a->elem);
 				palloc_free_page (a);
 			}
 
@@ -2,14 +2,18 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/cpu.h"
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -24,24 +28,114 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
+
+   Each pool is a binary buddy allocator.  Its free pages form
+   blocks of 2**ORDER pages whose index (relative to the pool's
+   base) is a multiple of 2**ORDER, kept on free_list[ORDER].  A
+   request for N pages takes a block of the smallest order that
+   fits, splitting larger blocks as needed, and gives back the
+   pages past N.  Freeing a block merges it with its buddy, the
+   other half of the block of the next order, for as long as the
+   buddy is free too.  Both take O(log n) steps, instead of the
+   O(n) bitmap scan this allocator used to do.
+
+   A free block's list_elem lives in its first page.  order_map
+   records, for every page, the order of the free block that
+   starts there, or ORDER_NONE, so that a buddy can be checked
+   without touching memory that may be in use.  used_map is still
+   kept up to date to catch double frees.
+
+   Pages are freed from places where a thread must not sleep, such
+   as schedule(), so a pool is protected by a spinlock with
+   interrupts off rather than by a struct lock.  Both operations
+   are short enough for that.
+
+   Most requests are for a single page (malloc arenas, thread
+   stacks, page tables, user frames), so each CPU keeps a small
+   cache of free pages per pool in front of the buddy allocator.
+   Single pages are taken from and returned to the cache with
+   only interrupts disabled; the pool's lock is taken once per
+   CACHE_BATCH pages to refill an empty cache or to drain a full
+   one.  Cached pages count as allocated in the buddy allocator,
+   so a request for several pages that fails drains the local cache
+   and tries again, but their used_map bits are clear, so that
+   freeing one of them again is caught.  bitmap_mark() and
+   bitmap_reset() are atomic, so this needs no lock.
+
+   Zeroing a page is the most expensive part of a PAL_ZERO request,
+   and it sits on the path of pml4_create(), thread creation and
+   page faults.  So a kernel thread at PRI_MIN, which only runs
+   when nothing else wants the CPU, keeps up to ZERO_TARGET zeroed
+   pages per pool in the pool's zeroed[] array, and a single-page
+   PAL_ZERO request just pops one.  The thread blocks once both
+   pools are full and is woken when one falls below ZERO_LOW.
+   Zeroed pages are allocated pages as far as the pool is
+   concerned; requests that would otherwise fail take them back. */
+
+#define MAX_ORDER 20                    /* Largest block: 4 GB. */
+#define ZERO_TARGET 64                  /* Zeroed pages kept per pool. */
+#define ZERO_LOW 32                     /* Refill below this many. */
+#define ORDER_NONE 0xff                 /* Not the head of a free block. */
+
+/* Header of a free block, in its first page. */
+struct free_block {
+	struct list_elem elem;          /* Element in a free_list. */
+};
 
 /* A memory pool. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
+	struct spinlock lock;           /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
+	uint8_t *order_map;             /* Order of free block at each page. */
 	uint8_t *base;                  /* Base of pool. */
+	size_t page_cnt;                /* Number of pages in the pool. */
+	struct list free_list[MAX_ORDER + 1]; /* Free blocks, by order. */
+
+	/* Pre-zeroed pages, protected by LOCK. */
+	void *zeroed[ZERO_TARGET];      /* Zeroed single pages. */
+	size_t zeroed_cnt;              /* Number of pages in ZEROED. */
+	uint64_t zero_hits;             /* PAL_ZERO pages popped from ZEROED. */
+	uint64_t zero_misses;           /* PAL_ZERO pages zeroed on demand. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+#define CACHE_SIZE 32                   /* Pages a cache can hold. */
+#define CACHE_BATCH 16                  /* Pages moved per refill or drain. */
+
+/* Free single pages of one pool, owned by one CPU. */
+struct page_cache {
+	size_t cnt;                     /* Number of pages in PAGES. */
+	void *pages[CACHE_SIZE];        /* Oldest first. */
+};
+
+/* Per-CPU caches, for the kernel pool and the user pool. */
+static struct page_cache page_caches[CPU_MAX][2];
+
+/* The thread that zeroes pages, if it is blocked waiting for
+   work, or a null pointer. */
+static struct thread *zero_waiter;
+
 /* Maximum number of pages to put in user pool. */
 size_t user_page_limit = SIZE_MAX;
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void build_free_lists (struct pool *);
+static void *pool_get (struct pool *, size_t page_cnt);
+static void pool_free (struct pool *, void *pages, size_t page_cnt);
+static struct page_cache *cache_of (struct pool *);
+static void *cache_get (struct pool *);
+static void cache_put (struct pool *, void *page);
+static void cache_drain (struct pool *, size_t page_cnt);
+static void *zeroed_take (struct pool *, bool count);
+static void zeroed_drain (struct pool *);
+static thread_func zero_thread;
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free (struct pool *, size_t page_idx, size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -232,6 +326,9 @@ split:
 			}
 		}
 	}
+
+	build_free_lists (&kernel_pool);
+	build_free_lists (&user_pool);
 }
 
 /* Initializes the page allocator and get the memory size */
@@ -250,6 +347,8 @@ palloc_init (void) {
 	printf ("\text_mem: 0x%llx ~ 0x%llx (Usable: %'llu kB)\n",
 		  ext_mem.start, ext_mem.end, ext_mem.size / 1024);
 	populate_pools (&base_mem, &ext_mem);
+	spinlock_set_name (&kernel_pool.lock, "palloc kernel");
+	spinlock_set_name (&user_pool.lock, "palloc user");
 	return ext_mem.end;
 }
 
@@ -262,19 +361,34 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	enum intr_level old_level;
+	void *pages = NULL;
+	bool zeroed = false;
 
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
-	void *pages;
+	if (page_cnt == 0)
+		return NULL;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	old_level = intr_disable ();
+	if (page_cnt == 1) {
+		if (flags & PAL_ZERO)
+			pages = zeroed_take (pool, true);
+		zeroed = pages != NULL;
+		if (pages == NULL)
+			pages = cache_get (pool);
+		if (pages == NULL)
+			pages = zeroed_take (pool, false);
+	} else {
+		pages = pool_get (pool, page_cnt);
+		if (pages == NULL) {
+			cache_drain (pool, CACHE_SIZE);
+			zeroed_drain (pool);
+			pages = pool_get (pool, page_cnt);
+		}
+	}
+	intr_set_level (old_level);
 
 	if (pages) {
-		if (flags & PAL_ZERO)
+		if ((flags & PAL_ZERO) && !zeroed)
 			memset (pages, 0, PGSIZE * page_cnt);
 	} else {
 		if (flags & PAL_ASSERT)
@@ -300,7 +414,7 @@ palloc_get_page (enum palloc_flags flags) {
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
-	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -313,13 +427,18 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 	else
 		NOT_REACHED ();
 
-	page_idx = pg_no (pages) - pg_no (pool->base);
-
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	old_level = intr_disable ();
+	if (page_cnt == 1)
+		cache_put (pool, pages);
+	else {
+		spinlock_acquire (&pool->lock);
+		pool_free (pool, pages, page_cnt);
+		spinlock_release (&pool->lock);
+	}
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -328,6 +447,212 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Allocates PAGE_CNT contiguous pages from POOL's free lists.
+   Interrupts must be off. */
+static void *
+pool_get (struct pool *pool, size_t page_cnt) {
+	size_t page_idx;
+
+	spinlock_acquire (&pool->lock);
+	page_idx = buddy_alloc (pool, page_cnt);
+	if (page_idx != BITMAP_ERROR) {
+		ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	}
+	spinlock_release (&pool->lock);
+
+	return page_idx != BITMAP_ERROR ? pool->base + PGSIZE * page_idx : NULL;
+}
+
+/* Returns the PAGE_CNT pages at PAGES to POOL's free lists.  The
+   caller must hold POOL's lock. */
+static void
+pool_free (struct pool *pool, void *pages, size_t page_cnt) {
+	size_t page_idx = pg_no (pages) - pg_no (pool->base);
+
+	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free (pool, page_idx, page_cnt);
+}
+
+/* Returns the running CPU's cache for POOL.  Interrupts must be
+   off, so that the thread stays on this CPU while it uses it. */
+static struct page_cache *
+cache_of (struct pool *pool) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	return &page_caches[cpu_current ()->id][pool == &user_pool];
+}
+
+/* Takes a page from the running CPU's cache for POOL, refilling
+   it from POOL if it is empty.  Returns a null pointer if POOL
+   has no free page either.  Interrupts must be off. */
+static void *
+cache_get (struct pool *pool) {
+	struct page_cache *c = cache_of (pool);
+	void *page;
+
+	if (c->cnt == 0) {
+		spinlock_acquire (&pool->lock);
+		while (c->cnt < CACHE_BATCH) {
+			size_t page_idx = buddy_alloc (pool, 1);
+			if (page_idx == BITMAP_ERROR)
+				break;
+			ASSERT (!bitmap_test (pool->used_map, page_idx));
+			c->pages[c->cnt++] = pool->base + PGSIZE * page_idx;
+		}
+		spinlock_release (&pool->lock);
+		if (c->cnt == 0)
+			return NULL;
+	}
+	page = c->pages[--c->cnt];
+	bitmap_mark (pool->used_map, pg_no (page) - pg_no (pool->base));
+	return page;
+}
+
+/* Puts PAGE into the running CPU's cache for POOL, first draining
+   part of it to POOL if it is full.  Interrupts must be off. */
+static void
+cache_put (struct pool *pool, void *page) {
+	struct page_cache *c = cache_of (pool);
+	size_t page_idx = pg_no (page) - pg_no (pool->base);
+
+	ASSERT (bitmap_test (pool->used_map, page_idx));
+	bitmap_reset (pool->used_map, page_idx);
+	if (c->cnt == CACHE_SIZE)
+		cache_drain (pool, CACHE_BATCH);
+	c->pages[c->cnt++] = page;
+}
+
+/* Returns up to PAGE_CNT of the oldest pages in the running CPU's
+   cache for POOL to POOL.  Interrupts must be off. */
+static void
+cache_drain (struct pool *pool, size_t page_cnt) {
+	struct page_cache *c = cache_of (pool);
+	size_t i;
+
+	if (page_cnt > c->cnt)
+		page_cnt = c->cnt;
+
+	spinlock_acquire (&pool->lock);
+	for (i = 0; i < page_cnt; i++) {
+		size_t page_idx = pg_no (c->pages[i]) - pg_no (pool->base);
+
+		ASSERT (!bitmap_test (pool->used_map, page_idx));
+		buddy_free (pool, page_idx, 1);
+	}
+	spinlock_release (&pool->lock);
+
+	c->cnt -= page_cnt;
+	memmove (c->pages, c->pages + page_cnt, c->cnt * sizeof *c->pages);
+}
+
+/* Pops a page from POOL's zeroed pages, or returns a null
+   pointer if there is none.  If COUNT, the request is counted as
+   a PAL_ZERO hit or miss.  Wakes the zeroing thread if POOL is
+   running low.  Interrupts must be off. */
+static void *
+zeroed_take (struct pool *pool, bool count) {
+	void *page = NULL;
+
+	spinlock_acquire (&pool->lock);
+	if (pool->zeroed_cnt > 0)
+		page = pool->zeroed[--pool->zeroed_cnt];
+	if (count) {
+		if (page != NULL)
+			pool->zero_hits++;
+		else
+			pool->zero_misses++;
+	}
+	spinlock_release (&pool->lock);
+
+	if (pool->zeroed_cnt < ZERO_LOW && zero_waiter != NULL) {
+		thread_unblock (zero_waiter);
+		zero_waiter = NULL;
+	}
+	return page;
+}
+
+/* Returns all of POOL's zeroed pages to its free lists.
+   Interrupts must be off. */
+static void
+zeroed_drain (struct pool *pool) {
+	spinlock_acquire (&pool->lock);
+	while (pool->zeroed_cnt > 0)
+		pool_free (pool, pool->zeroed[--pool->zeroed_cnt], 1);
+	spinlock_release (&pool->lock);
+}
+
+/* Returns a pool with fewer than ZERO_TARGET zeroed pages, or a
+   null pointer if both are full. */
+static struct pool *
+zero_wanted (void) {
+	if (kernel_pool.zeroed_cnt < ZERO_TARGET)
+		return &kernel_pool;
+	if (user_pool.zeroed_cnt < ZERO_TARGET)
+		return &user_pool;
+	return NULL;
+}
+
+/* Keeps both pools' zeroed pages topped up.  Blocks when they are
+   full, or when a pool has no free page to zero. */
+static void
+zero_thread (void *aux UNUSED) {
+	if (thread_mlfqs)
+		thread_set_nice (20);
+
+	for (;;) {
+		struct pool *pool = zero_wanted ();
+		enum intr_level old_level;
+		void *page = NULL;
+
+		/* palloc_get_page() would fall back on the zeroed pages
+		   themselves, so take a page from the free ones only. */
+		old_level = intr_disable ();
+		if (pool != NULL)
+			page = cache_get (pool);
+		if (page == NULL) {
+			zero_waiter = thread_current ();
+			thread_block ();
+			intr_set_level (old_level);
+			continue;
+		}
+		intr_set_level (old_level);
+
+		/* 가장 오래 걸리는 부분이므로 인터럽트를 켠 채로 한다. */
+		memset (page, 0, PGSIZE);
+
+		old_level = intr_disable ();
+		spinlock_acquire (&pool->lock);
+		if (pool->zeroed_cnt < ZERO_TARGET) {
+			pool->zeroed[pool->zeroed_cnt++] = page;
+			page = NULL;
+		}
+		spinlock_release (&pool->lock);
+		if (page != NULL)
+			cache_put (pool, page);
+		intr_set_level (old_level);
+	}
+}
+
+/* Starts the thread that zeroes free pages.  Must be called after
+   thread_start(). */
+void
+palloc_start (void) {
+	if (thread_create ("pagezero", PRI_MIN, zero_thread, NULL) == TID_ERROR)
+		PANIC ("palloc: cannot create thread");
+}
+
+/* Prints how many single-page PAL_ZERO requests were served from
+   the pre-zeroed pages. */
+void
+palloc_print_stats (void) {
+	uint64_t hits = kernel_pool.zero_hits + user_pool.zero_hits;
+	uint64_t total = hits + kernel_pool.zero_misses + user_pool.zero_misses;
+
+	printf ("Palloc: %llu of %llu zeroed pages pre-zeroed (%llu%%)\n",
+			hits, total, total > 0 ? hits * 100 / total : 0);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
@@ -335,18 +660,132 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      Calculate the space needed for the bitmap
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
-	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t bm_size = bitmap_buf_size (pgcnt);
+	size_t bm_pages = DIV_ROUND_UP (bm_size + pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
-	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
+	spinlock_init(&p->lock);
+	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_size);
+	p->order_map = (uint8_t *) *bm_base + bm_size;
 	p->base = (void *) start;
+	p->page_cnt = pgcnt;
+	for (order = 0; order <= MAX_ORDER; order++)
+		list_init (&p->free_list[order]);
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
+	memset (p->order_map, ORDER_NONE, pgcnt);
 
 	*bm_base += bm_pages;
 }
 
+/* Returns the first page of the block at PAGE_IDX in POOL. */
+static struct free_block *
+block_at (struct pool *pool, size_t page_idx) {
+	return (struct free_block *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Puts the block of 2**ORDER pages at PAGE_IDX on its free list. */
+static void
+block_insert (struct pool *pool, size_t page_idx, int order) {
+	list_push_front (&pool->free_list[order], &block_at (pool, page_idx)->elem);
+	pool->order_map[page_idx] = order;
+}
+
+/* Takes the free block at PAGE_IDX off its free list. */
+static void
+block_remove (struct pool *pool, size_t page_idx) {
+	list_remove (&block_at (pool, page_idx)->elem);
+	pool->order_map[page_idx] = ORDER_NONE;
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy as long as the buddy is free and of the same order. */
+static void
+block_free (struct pool *pool, size_t page_idx, int order) {
+	while (order < MAX_ORDER) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		if (buddy + ((size_t) 1 << order) > pool->page_cnt
+				|| pool->order_map[buddy] != order)
+			break;
+		block_remove (pool, buddy);
+		page_idx &= ~((size_t) 1 << order);
+		order++;
+	}
+	block_insert (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX, as the largest aligned
+   blocks that they can be split into. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < MAX_ORDER
+				&& page_idx % ((size_t) 2 << order) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		block_free (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Allocates PAGE_CNT contiguous pages from POOL and returns the
+   index of the first, or BITMAP_ERROR if no block is big
+   enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	int order = 0, i;
+	size_t page_idx;
+
+	while (((size_t) 1 << order) < page_cnt)
+		if (++order > MAX_ORDER)
+			return BITMAP_ERROR;
+
+	for (i = order; i <= MAX_ORDER; i++)
+		if (!list_empty (&pool->free_list[i]))
+			break;
+	if (i > MAX_ORDER)
+		return BITMAP_ERROR;
+
+	page_idx = pg_no (list_front (&pool->free_list[i])) - pg_no (pool->base);
+	block_remove (pool, page_idx);
+
+	/* Split down to ORDER, freeing the upper halves. */
+	while (i > order) {
+		i--;
+		block_insert (pool, page_idx + ((size_t) 1 << i), i);
+	}
+
+	/* Give back the pages past PAGE_CNT. */
+	buddy_free (pool, page_idx + page_cnt, ((size_t) 1 << order) - page_cnt);
+	return page_idx;
+}
+
+/* Adds every page that populate_pools() marked free in POOL's
+   used_map to its free lists. */
+static void
+build_free_lists (struct pool *pool) {
+	size_t start = 0;
+
+	while (start < pool->page_cnt) {
+		size_t end;
+
+		if (bitmap_test (pool->used_map, start)) {
+			start++;
+			continue;
+		}
+		end = bitmap_scan (pool->used_map, start, 1, true);
+		if (end == BITMAP_ERROR)
+			end = pool->page_cnt;
+		buddy_free (pool, start, end - start);
+		start = end;
+	}
+}
+
 /* Returns true if PAGE was allocated from POOL,
    false otherwise. */
 static bool
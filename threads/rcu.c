@@ -0,0 +1,254 @@
+#include "threads/rcu.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+
+/* Grace periods.
+
+   A grace period is over once every CPU that runs threads has
+   passed through a quiescent state since it began, and every
+   reader that was preempted inside a read-side critical section
+   that may have started before it has left that section.
+
+   A CPU passes through a quiescent state whenever it switches
+   threads (rcu_note_context_switch(), called by schedule()) and
+   whenever the timer interrupt finds the interrupted thread
+   outside any read-side critical section (rcu_tick()).  It
+   records that in cpu->rcu_qs, the number of the latest grace
+   period it has been quiescent in.
+
+   A thread switched out inside a read-side critical section goes
+   on blocked_list, tagged with the first grace period it must
+   hold up.  Tags never decrease along the list, so only its front
+   needs to be checked.  rcu_read_unlock() takes the thread off
+   again.
+
+   Callbacks go from next_list, to wait_list when a grace period
+   starts, to done_list when it ends, where the "rcu" thread runs
+   them. */
+
+/* Protects everything below. */
+static struct spinlock rcu_lock;
+
+static uint64_t gp_seq;         /* Latest grace period started. */
+static uint64_t gp_done;        /* Latest grace period completed. */
+
+static struct list blocked_list; /* Preempted readers. */
+
+static struct list next_list;   /* Callbacks waiting for a grace period. */
+static struct list wait_list;   /* Callbacks waiting for GP_SEQ to end. */
+static struct list done_list;   /* Callbacks ready to run. */
+
+static struct thread *rcu_thread;
+static bool rcu_thread_idle;    /* Blocked waiting for DONE_LIST? */
+
+static thread_func rcu_thread_func;
+static void rcu_advance (void);
+
+/* Initializes RCU.  The BSP runs threads from the start; each AP
+   joins with rcu_cpu_online() once it runs threads, and does not
+   hold up a grace period before that. */
+void
+rcu_init (void) {
+	spinlock_init (&rcu_lock);
+	list_init (&blocked_list);
+	list_init (&next_list);
+	list_init (&wait_list);
+	list_init (&done_list);
+	cpus[0].rcu_online = true;
+}
+
+/* Makes C, which is about to run threads, take part in grace
+   periods.  It counts as quiescent in the current one, since it
+   cannot be inside a read-side critical section yet. */
+void
+rcu_cpu_online (struct cpu *c) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	spinlock_acquire (&rcu_lock);
+	c->rcu_qs = gp_seq;
+	c->rcu_online = true;
+	spinlock_release (&rcu_lock);
+}
+
+/* Starts the thread that runs callbacks.  Must be called after
+   thread_start(). */
+void
+rcu_start (void) {
+	struct semaphore started;
+
+	sema_init (&started, 0);
+	if (thread_create ("rcu", PRI_MAX, rcu_thread_func, &started) == TID_ERROR)
+		PANIC ("rcu: cannot create thread");
+	sema_down (&started);
+}
+
+/* Arranges for FUNC to be called with HEAD after a grace period,
+   in the context of a kernel thread.  May be called from an
+   interrupt handler and inside a read-side critical section. */
+void
+call_rcu (struct rcu_head *head, rcu_func *func) {
+	enum intr_level old_level;
+
+	ASSERT (head != NULL);
+	ASSERT (func != NULL);
+
+	head->func = func;
+	old_level = intr_disable ();
+	spinlock_acquire (&rcu_lock);
+	list_push_back (&next_list, &head->elem);
+	rcu_advance ();
+	spinlock_release (&rcu_lock);
+	intr_set_level (old_level);
+}
+
+/* synchronize_rcu()가 기다리는 콜백. */
+struct rcu_sync {
+	struct rcu_head head;
+	struct semaphore done;
+};
+
+static void
+rcu_sync_done (struct rcu_head *head) {
+	struct rcu_sync *sync = list_entry (&head->elem, struct rcu_sync, head.elem);
+	sema_up (&sync->done);
+}
+
+/* Waits until a full grace period has passed, so that every
+   read-side critical section that was running when this was
+   called has ended. */
+void
+synchronize_rcu (void) {
+	struct rcu_sync sync;
+
+	ASSERT (!intr_context ());
+	ASSERT (!rcu_read_lock_held ());
+
+	sema_init (&sync.done, 0);
+	call_rcu (&sync.head, rcu_sync_done);
+	sema_down (&sync.done);
+}
+
+/* Called by schedule(), with interrupts off, when the current
+   CPU stops running PREV (or runs it again after a yield). */
+void
+rcu_note_context_switch (struct thread *prev) {
+	struct cpu *c = cpu_current ();
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (prev->rcu_nesting == 0 || prev->rcu_blocked) {
+		/* 오래된 gp_seq를 읽으면 보고가 늦어질 뿐이다. */
+		c->rcu_qs = gp_seq;
+		return;
+	}
+
+	/* 읽기 구역 안에서 밀려났다.  이 CPU가 아직 지금 grace period에서
+	   정지 상태를 보고하지 않았다면 PREV는 그 전부터 읽고 있었을 수 있다. */
+	spinlock_acquire (&rcu_lock);
+	prev->rcu_blocked = true;
+	prev->rcu_blocked_gp = c->rcu_qs < gp_seq ? gp_seq : gp_seq + 1;
+	list_push_back (&blocked_list, &prev->rcu_elem);
+	c->rcu_qs = gp_seq;
+	spinlock_release (&rcu_lock);
+}
+
+/* Called by the timer interrupt on every tick. */
+void
+rcu_tick (void) {
+	struct cpu *c = cpu_current ();
+
+	if (thread_current ()->rcu_nesting == 0)
+		c->rcu_qs = gp_seq;
+	if (gp_done == gp_seq && list_empty (&next_list))
+		return;
+
+	spinlock_acquire (&rcu_lock);
+	rcu_advance ();
+	spinlock_release (&rcu_lock);
+}
+
+/* Slow path of rcu_read_unlock(): the thread was preempted inside
+   the critical section it just left. */
+void
+rcu_read_unlock_special (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	spinlock_acquire (&rcu_lock);
+	if (t->rcu_blocked) {
+		list_remove (&t->rcu_elem);
+		t->rcu_blocked = false;
+	}
+	spinlock_release (&rcu_lock);
+	intr_set_level (old_level);
+}
+
+/* 지금 grace period가 끝났는지 확인한다.  rcu_lock을 잡고 호출. */
+static bool
+gp_ended (void) {
+	struct cpu *c;
+
+	for (c = cpus; c < cpus + cpu_cnt; c++)
+		if (c->rcu_online && c->rcu_qs < gp_seq)
+			return false;
+	if (!list_empty (&blocked_list)) {
+		struct thread *t = list_entry (list_front (&blocked_list),
+				struct thread, rcu_elem);
+		if (t->rcu_blocked_gp <= gp_seq)
+			return false;
+	}
+	return true;
+}
+
+/* Ends the current grace period if it is over, and starts the
+   next one if callbacks are waiting for it.  rcu_lock을 잡고 호출. */
+static void
+rcu_advance (void) {
+	ASSERT (spinlock_held_by_current_cpu (&rcu_lock));
+
+	if (gp_done != gp_seq && gp_ended ()) {
+		gp_done = gp_seq;
+		while (!list_empty (&wait_list))
+			list_push_back (&done_list, list_pop_front (&wait_list));
+		if (rcu_thread_idle) {
+			rcu_thread_idle = false;
+			thread_unblock (rcu_thread);
+		}
+	}
+	if (gp_done == gp_seq && !list_empty (&next_list)) {
+		gp_seq++;
+		while (!list_empty (&next_list))
+			list_push_back (&wait_list, list_pop_front (&next_list));
+	}
+}
+
+/* Runs the callbacks of finished grace periods. */
+static void
+rcu_thread_func (void *started_) {
+	struct semaphore *started = started_;
+
+	rcu_thread = thread_current ();
+	sema_up (started);
+
+	for (;;) {
+		struct rcu_head *head;
+
+		intr_disable ();
+		spinlock_acquire (&rcu_lock);
+		if (list_empty (&done_list)) {
+			rcu_thread_idle = true;
+			spinlock_release (&rcu_lock);
+			thread_block ();
+			intr_enable ();
+			continue;
+		}
+		head = list_entry (list_pop_front (&done_list), struct rcu_head, elem);
+		spinlock_release (&rcu_lock);
+		intr_enable ();
+
+		head->func (head);
+	}
+}
@@ -0,0 +1,296 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Slab allocator.
+
+   malloc() rounds every request up to a power of two, so an
+   object a little larger than one wastes almost half of its
+   block.  A kmem_cache instead hands out objects of one exact
+   size, packed into one-page "slabs".  Each slab starts with a
+   struct slab and an array of free-object indexes, followed by
+   the objects themselves.
+
+   A cache keeps its slabs on three lists: full ones, partially
+   used ones, which allocations are taken from first, and empty
+   ones.  At most EMPTY_MAX empty slabs are kept; the rest go back
+   to the page allocator.
+
+   If the cache has a constructor, it runs on every object once,
+   when the object's slab is created.  The caller must return an
+   object to the cache in its constructed state, so reusing it
+   costs nothing.  The slab's free list is kept outside the
+   objects for this reason.
+
+   The space left over at the end of a slab is used to "color"
+   it: each new slab starts its objects COLOR_ALIGN bytes further
+   in than the last one, cycling, so that the same object in
+   different slabs does not always map to the same cache sets. */
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+#define COLOR_ALIGN 64                  /* Size of a CPU cache line. */
+#define EMPTY_MAX 1                     /* Empty slabs kept per cache. */
+#define FREE_END UINT16_MAX             /* End of a slab's free list. */
+
+/* Object cache. */
+struct kmem_cache {
+	char name[16];              /* For statistics. */
+	size_t size;                /* Object size, a multiple of ALIGN. */
+	kmem_ctor_func *ctor;       /* Constructor, or a null pointer. */
+	size_t objs_per_slab;       /* Objects in each slab. */
+	size_t obj_ofs;             /* Offset of object 0 in an uncolored slab. */
+	size_t color_unit;          /* Offset between two colors. */
+	size_t color_cnt;           /* Number of different colors. */
+	size_t color_next;          /* Color of the next slab. */
+	struct list full;           /* Slabs with no free object. */
+	struct list partial;        /* Slabs with free and used objects. */
+	struct list empty;          /* Slabs with no used object. */
+	size_t empty_cnt;           /* Number of slabs in EMPTY. */
+	size_t slab_cnt;            /* Number of slabs. */
+	size_t in_use;              /* Number of allocated objects. */
+	struct lock lock;           /* Protects the fields above. */
+	struct list_elem elem;      /* Element in cache_list. */
+};
+
+/* Slab header, at the start of the slab's page. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* Element in one of the cache's lists. */
+	uint8_t *objs;              /* Object 0. */
+	size_t in_use;              /* Number of allocated objects. */
+	uint16_t free;              /* First free object, or FREE_END. */
+	uint16_t next[];            /* Next free object after each object. */
+};
+
+/* All caches, for kmem_cache_print_stats(). */
+static struct list cache_list;
+
+static struct slab *slab_create (struct kmem_cache *);
+static void slab_destroy (struct kmem_cache *, struct slab *);
+
+/* Initializes the slab allocator. */
+void
+kmem_cache_init (void) {
+	list_init (&cache_list);
+}
+
+/* Creates and returns a cache of objects SIZE bytes long, aligned
+   on ALIGN bytes (a power of two, or 0 for pointer alignment).
+   CTOR, if nonnull, constructs each object.  NAME is used in
+   statistics.  Returns a null pointer if memory is not available
+   or if SIZE is too big for a slab. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	enum intr_level old_level;
+	size_t n, ofs;
+
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT (align <= PGSIZE && (align & (align - 1)) == 0);
+	size = ROUND_UP (size > 0 ? size : 1, align);
+
+	/* Fit as many objects as possible, with their free-list
+	   entries, after the header. */
+	n = (PGSIZE - sizeof (struct slab)) / (size + sizeof (uint16_t));
+	if (n >= FREE_END)
+		n = FREE_END - 1;
+	for (; n > 0; n--) {
+		ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+		if (ofs + n * size <= PGSIZE)
+			break;
+	}
+	if (n == 0)
+		return NULL;
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		return NULL;
+	strlcpy (c->name, name, sizeof c->name);
+	c->size = size;
+	c->ctor = ctor;
+	c->objs_per_slab = n;
+	c->obj_ofs = ofs;
+	c->color_unit = align > COLOR_ALIGN ? align : COLOR_ALIGN;
+	c->color_cnt = (PGSIZE - ofs - n * size) / c->color_unit + 1;
+	c->color_next = 0;
+	list_init (&c->full);
+	list_init (&c->partial);
+	list_init (&c->empty);
+	c->empty_cnt = 0;
+	c->slab_cnt = 0;
+	c->in_use = 0;
+	lock_init (&c->lock);
+	/* The profiler keeps the name after C is destroyed. */
+	lock_set_name (&c->lock, "slab");
+
+	old_level = intr_disable ();
+	list_push_back (&cache_list, &c->elem);
+	intr_set_level (old_level);
+	return c;
+}
+
+/* Destroys cache C, which must have no allocated objects. */
+void
+kmem_cache_destroy (struct kmem_cache *c) {
+	enum intr_level old_level;
+
+	if (c == NULL)
+		return;
+	ASSERT (c->in_use == 0);
+
+	while (!list_empty (&c->empty)) {
+		struct list_elem *e = list_pop_front (&c->empty);
+		slab_destroy (c, list_entry (e, struct slab, elem));
+	}
+
+	old_level = intr_disable ();
+	list_remove (&c->elem);
+	intr_set_level (old_level);
+	free (c);
+}
+
+/* Allocates and returns an object from C, in its constructed
+   state.  Returns a null pointer if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	void *obj;
+
+	lock_acquire (&c->lock);
+	if (!list_empty (&c->partial))
+		s = list_entry (list_front (&c->partial), struct slab, elem);
+	else if (!list_empty (&c->empty)) {
+		s = list_entry (list_pop_front (&c->empty), struct slab, elem);
+		c->empty_cnt--;
+		list_push_front (&c->partial, &s->elem);
+	} else {
+		s = slab_create (c);
+		if (s == NULL) {
+			lock_release (&c->lock);
+			return NULL;
+		}
+		list_push_front (&c->partial, &s->elem);
+	}
+
+	ASSERT (s->free != FREE_END);
+	obj = s->objs + s->free * c->size;
+	s->free = s->next[s->free];
+	s->in_use++;
+	c->in_use++;
+	if (s->free == FREE_END) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	lock_release (&c->lock);
+
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from C and be back
+   in its constructed state, to C.  Does nothing if OBJ is a null
+   pointer. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down (obj);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	idx = ((uint8_t *) obj - s->objs) / c->size;
+	ASSERT (s->objs + idx * c->size == obj);
+
+	lock_acquire (&c->lock);
+	ASSERT (s->in_use > 0);
+	if (s->free == FREE_END) {
+		/* Full to partial. */
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	s->next[idx] = s->free;
+	s->free = idx;
+	s->in_use--;
+	c->in_use--;
+	if (s->in_use == 0) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else
+			slab_destroy (c, s);
+	}
+	lock_release (&c->lock);
+}
+
+/* Returns the number of objects that fit in one of C's slabs. */
+size_t
+kmem_cache_objs_per_slab (const struct kmem_cache *c) {
+	return c->objs_per_slab;
+}
+
+/* Prints the memory used by each cache. */
+void
+kmem_cache_print_stats (void) {
+	struct list_elem *e;
+
+	for (e = list_begin (&cache_list); e != list_end (&cache_list);
+			e = list_next (e)) {
+		struct kmem_cache *c = list_entry (e, struct kmem_cache, elem);
+		printf ("Slab %s: %zu-byte objects, %zu in use, %zu per page, "
+				"%zu pages\n", c->name, c->size, c->in_use, c->objs_per_slab,
+				c->slab_cnt);
+	}
+}
+
+/* Allocates a new slab for C and constructs its objects.  The
+   caller must hold C's lock. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->objs = (uint8_t *) s + c->obj_ofs + c->color_next * c->color_unit;
+	c->color_next = (c->color_next + 1) % c->color_cnt;
+	s->in_use = 0;
+	s->free = 0;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		s->next[i] = i + 1 < c->objs_per_slab ? i + 1 : FREE_END;
+		if (c->ctor != NULL)
+			c->ctor (s->objs + i * c->size);
+	}
+	c->slab_cnt++;
+	return s;
+}
+
+/* Returns slab S, which has no allocated objects and is on none
+   of C's lists, to the page allocator.  The caller must hold C's
+   lock, or be the only user of C. */
+static void
+slab_destroy (struct kmem_cache *c, struct slab *s) {
+	ASSERT (s->in_use == 0);
+	s->magic = 0;
+	c->slab_cnt--;
+	palloc_free_page (s);
+}
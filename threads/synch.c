@@ -44,8 +44,12 @@
 #include "threads/synch.h"
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
 #include "threads/interrupt.h"
+#include "threads/lockstat.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -108,6 +112,64 @@ void sema_down(struct semaphore *sema)
    intr_set_level(old_level);
 }
 
+/* sema_down_timeout()에서 기다리는 쓰레드와 그 상태. */
+struct sema_waiter
+{
+   struct thread *thread;
+   bool timed_out;
+};
+
+/* sema_down_timeout()의 timeout 콜백.  시간이 다 됐다고 표시하고,
+   아직 세마포어를 기다리고 있으면 (BLOCKED) 대기 목록에서 빼서 깨운다.
+   sema_up()이 이미 깨웠더라도 표시는 해야 한다.  그 사이 다른 쓰레드가
+   값을 가져가면 대기 루프가 timeout 없이 다시 잠들기 때문이다. */
+static void sema_timeout_expire(void *w_)
+{
+   struct sema_waiter *w = w_;
+
+   w->timed_out = true;
+   if (w->thread->status == THREAD_BLOCKED)
+   {
+      list_remove(&w->thread->elem);
+      thread_unblock(w->thread);
+   }
+}
+
+/* Like sema_down(), but gives up after TICKS timer ticks.
+   Returns true if SEMA was decremented, false on timeout.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+bool sema_down_timeout(struct semaphore *sema, int64_t ticks)
+{
+   struct sema_waiter w = {thread_current(), false};
+   enum intr_level old_level;
+   struct timeout to;
+   bool success;
+
+   ASSERT(sema != NULL);
+   ASSERT(!intr_context());
+
+   old_level = intr_disable();
+   if (sema->value == 0 && ticks > 0)
+   {
+      timeout_init(&to, sema_timeout_expire, &w);
+      timeout_add(&to, timer_ticks() + ticks);
+      while (sema->value == 0 && !w.timed_out)
+      {
+         list_push_back(&sema->waiters, &thread_current()->elem);
+         thread_block();
+      }
+      timeout_cancel(&to);
+   }
+   success = sema->value > 0;
+   if (success)
+      sema->value--;
+   intr_set_level(old_level);
+
+   return success;
+}
+
 /* Down or "P" operation on a semaphore, but only if the
    semaphore is not already 0.  Returns true if the semaphore is
    decremented, false otherwise.
@@ -141,7 +203,7 @@ bool cmp_priority_max(const struct list_elem *a_, const struct list_elem *b_, vo
 {
    const struct thread *a = list_entry(a_, struct thread, elem);
    const struct thread *b = list_entry(b_, struct thread, elem);
-   return (thread_get_priority_manual(a) < thread_get_priority_manual(b));
+   return a->effective_priority < b->effective_priority;
 }
 
 /* Up or "V" operation on a semaphore.  Increments SEMA's value
@@ -152,26 +214,34 @@ bool cmp_priority_max(const struct list_elem *a_, const struct list_elem *b_, vo
    SEMA를 기다리는 스레드 중 하나를 깨웁니다(만약 대기 중인 스레드가 있다면).
    이 함수는 인터럽트 핸들러에서 호출될 수 있습니다. */
 
-void sema_up(struct semaphore *sema)
+/* sema_up()에서 양보만 뺀 것.  인터럽트가 꺼진 상태에서 호출하며,
+   깨운 쓰레드의 우선순위를 (없으면 PRI_MIN - 1) 돌려준다. */
+static int sema_wake(struct semaphore *sema)
 {
-   enum intr_level old_level;
    struct thread *max_t;
-   struct thread *curr = thread_current();
    struct list_elem *max_elem;
 
-   ASSERT(sema != NULL);
+   ASSERT(intr_get_level() == INTR_OFF);
 
-   old_level = intr_disable();
+   sema->value++;
+   if (list_empty(&sema->waiters))
+      return PRI_MIN - 1;
+
+   max_elem = list_max((&sema->waiters), cmp_priority_max, NULL);
+   max_t = list_entry(max_elem, struct thread, elem);
+   list_remove(max_elem);
+   thread_unblock(max_t);
+   return max_t->effective_priority;
+}
 
-   if (!list_empty(&sema->waiters))
-   {
-      max_elem = list_max((&sema->waiters), cmp_priority_max, NULL);
-      max_t = list_entry(max_elem, struct thread, elem);
-      list_remove(max_elem);
-      thread_unblock(max_t);
-   }
+void sema_up(struct semaphore *sema)
+{
+   enum intr_level old_level;
 
-   sema->value++;
+   ASSERT(sema != NULL);
+
+   old_level = intr_disable();
+   sema_wake(sema);
    thread_yield();
    intr_set_level(old_level);
 }
@@ -243,16 +313,172 @@ sema_test_helper(void *sema_)
 void lock_init(struct lock *lock)
 {
    ASSERT(lock != NULL);
+   lock->owner = 0;
    lock->holder = NULL;
-   for (int i = 0; i < 64; i++)
-      lock->donation_list[i] = 0;
-   sema_init(&lock->semaphore, 1);
+   list_init(&lock->waiters);
+   lock->donation_bitmap = 0;
+#ifdef LOCKSTAT
+   lock->stat = lockstat_site(__builtin_return_address(0));
+#endif
+}
+
+/* Names LOCK for the lock profiler, which then counts it together
+   with every other lock of that NAME instead of by the place that
+   initialized it.  NAME must be a string that lives forever.
+   Does nothing unless the kernel is built with LOCKSTAT. */
+void lock_set_name(struct lock *lock UNUSED, const char *name UNUSED)
+{
+#ifdef LOCKSTAT
+   lock->stat = lockstat_named(name);
+#endif
+}
+
+/* LOCK을 가진 쓰레드.  비어 있으면 NULL. */
+static struct thread *lock_owner(const struct lock *lock)
+{
+   return (struct thread *)(lock->owner & ~(uint64_t)LOCK_WAITERS);
+}
+
+/* LOCK이 비어 있으면 한 번의 cmpxchg로 잡는다.  WAITERS가 참이면
+   대기자가 남아 있다고 표시한다. */
+static bool lock_try_owner(struct lock *lock, bool waiters)
+{
+   uint64_t curr = (uint64_t)thread_current();
+
+   if (waiters)
+      curr |= LOCK_WAITERS;
+   return lock->owner == 0 && cmpxchg(&lock->owner, 0, curr) == 0;
+}
+
+/* 현재 쓰레드를 LOCK의 holder로 기록한다.  held_locks는 주인 쓰레드만
+   건드리므로 인터럽트를 끄지 않아도 된다. */
+static void lock_set_holder(struct lock *lock)
+{
+   struct thread *curr = thread_current();
+
+   lock->holder = curr;
+   list_push_back(&curr->held_locks, &lock->elem);
+#ifdef LOCKSTAT
+   __atomic_add_fetch(&lock->stat->acquired, 1, __ATOMIC_RELAXED);
+   lock->acquired_tsc = rdtsc();
+#endif
+}
+
+#ifdef LOCKSTAT
+/* lockstat: LOCK을 START(rdtsc)부터 기다린 끝에 잡았다. */
+static void lock_note_wait(struct lock *lock, uint64_t start)
+{
+   __atomic_add_fetch(&lock->stat->contended, 1, __ATOMIC_RELAXED);
+   __atomic_add_fetch(&lock->stat->wait_cycles, rdtsc() - start, __ATOMIC_RELAXED);
+}
+
+/* lockstat: 풀기 직전의 LOCK이 잡혀 있던 시간을 반영한다. */
+static void lock_note_release(struct lock *lock)
+{
+   uint64_t hold = rdtsc() - lock->acquired_tsc;
+
+   if (hold > lock->stat->hold_max_cycles)
+      lock->stat->hold_max_cycles = hold;
+}
+#endif
+
+static void rwlock_donate(struct rwlock *, int pri);
+
+/* T가 가진 락과 rwlock들에 기록된 기부를 다시 모아 유효 우선순위를 갱신한다.
+   인터럽트를 끄고 호출. */
+static void collect_donations(struct thread *t)
+{
+   struct list_elem *e;
+   int i;
+
+   t->donation_bitmap = 0;
+   for (e = list_begin(&t->held_locks); e != list_end(&t->held_locks); e = list_next(e))
+      t->donation_bitmap |= list_entry(e, struct lock, elem)->donation_bitmap;
+   for (i = 0; i < RWLOCK_HOLD_MAX; i++)
+      if (t->rw_holds[i].rwlock != NULL)
+         t->donation_bitmap |= t->rw_holds[i].donation_bitmap;
+   thread_update_priority(t);
+}
+
+/* LOCK의 holder에게 우선순위 PRI를 기부하고, holder가 다른 락을 기다리는
+   중이면 사슬을 따라 계속 전달한다.  인터럽트를 끄고 호출.
+   기부는 각 락에 기록되어 lock_release() 때 한꺼번에 회수된다.
+
+   holder의 기본 우선순위가 이미 PRI 이상이거나 락에 PRI 이상의 기부가
+   이미 기록되어 있으면 멈춘다.  그 holder가 기다리기 시작할 때 (또는 그
+   기부를 받을 때) 자기 유효 우선순위를 사슬 아래로 이미 전달했기 때문이다.
+   기부는 LOCK_WAITERS가 켜진 락으로만 흐르므로, 대기자가 없는 락은 기부도
+   없다. */
+static void donate(struct lock *lock, int pri)
+{
+   ASSERT(intr_get_level() == INTR_OFF);
+
+   while (lock != NULL && lock_owner(lock) != NULL)
+   {
+      struct thread *holder = lock_owner(lock);
+
+      if (holder->priority >= pri || (lock->donation_bitmap >> pri) != 0)
+         break;
+      lock->donation_bitmap |= 1ULL << pri;
+      holder->donation_bitmap |= 1ULL << pri;
+      thread_update_priority(holder);
+      if (holder->wait_on_rwlock != NULL)
+         rwlock_donate(holder->wait_on_rwlock, pri);
+      lock = holder->wait_on_lock;
+   }
+}
+
+/* Number of times lock_acquire() polls a lock whose holder is
+   running on another CPU before it blocks. */
+#define LOCK_SPIN_MAX 1000
+
+/* T가 지금 어떤 online CPU에서 실행 중인가.  T는 이미 끝나 해제된
+   쓰레드일 수도 있으므로 T를 읽지 않고 각 CPU가 실행 중인 쓰레드와
+   비교만 한다. */
+static bool thread_on_cpu(const struct thread *t)
+{
+   struct cpu *c;
+
+   for (c = cpus; c < cpus + cpu_cnt; c++)
+      if (c->online && c->running == t)
+         return true;
+   return false;
+}
+
+/* LOCK의 holder가 다른 CPU에서 실행 중인 동안 잠깐 기다리며 락이 풀리기를
+   기다린다.  짧은 임계 구역이면 잠들고 깨는 비용을 아낀다.  holder가
+   실행 중이 아니면 (잠들었거나 이 CPU에서 밀려났으면) 기다려도 소용없다. */
+static bool lock_spin(struct lock *lock)
+{
+   struct thread *curr = thread_current();
+   int spin;
+
+   for (spin = 0; spin < LOCK_SPIN_MAX; spin++)
+   {
+      struct thread *holder = lock_owner(lock);
+
+      if (holder == NULL)
+      {
+         if (lock_try_owner(lock, false))
+            return true;
+      }
+      else if (holder == curr || !thread_on_cpu(holder))
+         break;
+      cpu_relax();
+   }
+   return false;
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
    necessary.  The lock must not already be held by the current
    thread.
 
+   A free lock is taken with a single cmpxchg and without
+   disabling interrupts.  If the holder is running on another
+   CPU, spins for a while first, since the lock is likely to be
+   released soon.  Otherwise the thread donates its priority to
+   the holder and blocks.
+
    This function may sleep, so it must not be called within an
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
@@ -270,50 +496,64 @@ void lock_acquire(struct lock *lock)
    ASSERT(!lock_held_by_current_thread(lock));
    struct thread *curr_t = thread_current();
    struct thread *max_waiter_t;
-   struct list_elem *max_waiter_elem;
+   enum intr_level old_level;
+   int64_t wait_start;
+#ifdef LOCKSTAT
+   uint64_t contended_tsc;
+#endif
 
-   if (thread_mlfqs)
+   if (lock_try_owner(lock, false))
+   {
+      lock_set_holder(lock);
+      return;
+   }
+#ifdef LOCKSTAT
+   contended_tsc = rdtsc();
+#endif
+   if (lock_spin(lock))
    {
-      sema_down(&lock->semaphore);
-      curr_t->wait_on_lock = NULL;
-      lock->holder = curr_t;
+      lock_set_holder(lock);
+#ifdef LOCKSTAT
+      lock_note_wait(lock, contended_tsc);
+#endif
       return;
    }
 
-   if (lock->holder != NULL)
+   /* 기부 사슬을 따라가는 동안 holder가 바뀌지 않도록 */
+   old_level = intr_disable();
+   for (;;)
    {
-      curr_t->wait_on_lock = lock;
+      uint64_t owner = lock->owner;
 
-      int curr_priority = thread_get_priority();
-      struct lock *next_lock = lock;
-      while (next_lock != NULL)
+      if (owner == 0)
       {
-         if (next_lock->holder->priority < curr_priority)
-         {
-            next_lock->holder->donation_cnt++;
-            next_lock->holder->donation_list[curr_priority]++;
-            next_lock->donation_list[curr_priority]++;
-            if (next_lock->holder->status == THREAD_READY)
-               thread_relocate_ready(next_lock->holder);
-         }
-         next_lock = next_lock->holder->wait_on_lock;
+         if (lock_try_owner(lock, !list_empty(&lock->waiters)))
+            break;
+         continue;
       }
+      /* 대기자 표시를 먼저 해 두어야 holder가 빠른 경로로 풀지 않는다. */
+      if (!(owner & LOCK_WAITERS) && cmpxchg(&lock->owner, owner, owner | LOCK_WAITERS) != owner)
+         continue;
+
+      curr_t->wait_on_lock = lock;
+      if (!thread_mlfqs)
+         donate(lock, curr_t->effective_priority);
+      list_push_back(&lock->waiters, &curr_t->elem);
+      wait_start = timer_ns();
+      thread_block();
+      curr_t->stats.lock_ns += timer_ns() - wait_start;
    }
-   sema_down(&lock->semaphore);
    curr_t->wait_on_lock = NULL;
-   lock->holder = curr_t;
-   if (!list_empty(&lock->semaphore.waiters))
+   lock_set_holder(lock);
+#ifdef LOCKSTAT
+   lock_note_wait(lock, contended_tsc);
+#endif
+   if (!thread_mlfqs && !list_empty(&lock->waiters))
    {
-      max_waiter_elem = list_max((&lock->semaphore.waiters), cmp_priority_max, NULL);
-      max_waiter_t = list_entry(max_waiter_elem, struct thread, elem);
-      int max_priority = thread_get_priority_manual(max_waiter_t);
-      if (curr_t->priority < max_priority)
-      {
-         curr_t->donation_cnt++;
-         curr_t->donation_list[max_priority]++;
-         lock->donation_list[max_priority]++;
-      }
+      max_waiter_t = list_entry(list_max(&lock->waiters, cmp_priority_max, NULL), struct thread, elem);
+      donate(lock, max_waiter_t->effective_priority);
    }
+   intr_set_level(old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -334,15 +574,18 @@ bool lock_try_acquire(struct lock *lock)
    ASSERT(lock != NULL);
    ASSERT(!lock_held_by_current_thread(lock));
 
-   success = sema_try_down(&lock->semaphore);
+   success = lock_try_owner(lock, false);
    if (success)
-      lock->holder = thread_current();
+      lock_set_holder(lock);
    return success;
 }
 
 /* Releases LOCK, which must be owned by the current thread.
    This is lock_release function.
 
+   If no thread waits for LOCK, it has received no donations
+   either, and a single cmpxchg releases it.
+
    An interrupt handler cannot acquire a lock, so it does not
    make sense to try to release a lock within an interrupt
    handler.
@@ -357,17 +600,36 @@ void lock_release(struct lock *lock)
    ASSERT(lock != NULL);
    ASSERT(lock_held_by_current_thread(lock));
    struct thread *t = thread_current();
-   if (!thread_mlfqs)
+   enum intr_level old_level;
+   struct list_elem *e;
+
+#ifdef LOCKSTAT
+   lock_note_release(lock);
+#endif
+   list_remove(&lock->elem);
+   lock->holder = NULL;
+   if (cmpxchg(&lock->owner, (uint64_t)t, 0) == (uint64_t)t)
+      return;
+
+   old_level = intr_disable();
+   /* 이 락으로 받은 기부를 회수한다.  같은 우선순위를 다른 락으로도
+      받았을 수 있으므로 남은 락들의 비트맵을 다시 모은다. */
+   if (lock->donation_bitmap != 0)
    {
-      for (int i = 0; i < 63; i++)
-      {
-         t->donation_list[i] -= lock->donation_list[i];
-         t->donation_cnt -= lock->donation_list[i];
-         lock->donation_list[i] = 0;
-      }
+      lock->donation_bitmap = 0;
+      collect_donations(t);
    }
-   lock->holder = NULL;
-   sema_up(&lock->semaphore);
+   /* 가장 높은 대기자를 깨운다.  깨어난 쓰레드는 락을 다시 잡으려 하고,
+      남은 대기자가 있으면 LOCK_WAITERS를 다시 켠다. */
+   lock->owner = 0;
+   if (!list_empty(&lock->waiters))
+   {
+      e = list_max(&lock->waiters, cmp_priority_max, NULL);
+      list_remove(e);
+      thread_unblock(list_entry(e, struct thread, elem));
+   }
+   thread_yield();
+   intr_set_level(old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -379,7 +641,215 @@ bool lock_held_by_current_thread(const struct lock *lock)
 {
    ASSERT(lock != NULL);
 
-   return lock->holder == thread_current();
+   return lock_owner(lock) == thread_current();
+}
+
+/* Initializes RW as an unheld reader-writer lock. */
+void rwlock_init(struct rwlock *rw)
+{
+   ASSERT(rw != NULL);
+
+   rw->readers = 0;
+   rw->writer = NULL;
+   rw->waiting_writers = 0;
+   list_init(&rw->holders);
+   list_init(&rw->read_waiters);
+   list_init(&rw->write_waiters);
+}
+
+/* hold H의 쓰레드에게 우선순위 PRI를 기부하고 그 쓰레드가 기다리는 락이나
+   rwlock으로 계속 전달한다.  멈추는 조건은 donate()와 같다. */
+static void rwlock_hold_donate(struct rwlock_hold *h, int pri)
+{
+   struct thread *t = h->thread;
+
+   if (t->priority >= pri || (h->donation_bitmap >> pri) != 0)
+      return;
+   h->donation_bitmap |= 1ULL << pri;
+   t->donation_bitmap |= 1ULL << pri;
+   thread_update_priority(t);
+   if (t->wait_on_lock != NULL)
+      donate(t->wait_on_lock, pri);
+   else if (t->wait_on_rwlock != NULL)
+      rwlock_donate(t->wait_on_rwlock, pri);
+}
+
+/* RW를 가진 모든 쓰레드 (reader 전부 또는 writer)에게 PRI를 기부한다.
+   인터럽트를 끄고 호출. */
+static void rwlock_donate(struct rwlock *rw, int pri)
+{
+   struct list_elem *e;
+
+   ASSERT(intr_get_level() == INTR_OFF);
+
+   for (e = list_begin(&rw->holders); e != list_end(&rw->holders); e = list_next(e))
+      rwlock_hold_donate(list_entry(e, struct rwlock_hold, elem), pri);
+}
+
+/* 현재 쓰레드의 RW에 대한 hold.  없으면 NULL. */
+static struct rwlock_hold *rwlock_find_hold(const struct rwlock *rw)
+{
+   struct thread *curr = thread_current();
+   int i;
+
+   for (i = 0; i < RWLOCK_HOLD_MAX; i++)
+      if (curr->rw_holds[i].rwlock == rw)
+         return &curr->rw_holds[i];
+   return NULL;
+}
+
+/* 현재 쓰레드를 WAITERS에 넣고 RW가 풀릴 때까지 잔다.  인터럽트를 끄고 호출. */
+static void rwlock_wait(struct rwlock *rw, struct list *waiters)
+{
+   struct thread *curr = thread_current();
+   int64_t wait_start;
+
+   curr->wait_on_rwlock = rw;
+   if (!thread_mlfqs)
+      rwlock_donate(rw, curr->effective_priority);
+   list_push_back(waiters, &curr->elem);
+   wait_start = timer_ns();
+   thread_block();
+   curr->stats.lock_ns += timer_ns() - wait_start;
+   curr->wait_on_rwlock = NULL;
+}
+
+/* 현재 쓰레드를 RW의 holder로 기록하고, 아직 기다리는 쓰레드 중 가장 높은
+   우선순위를 기부받는다.  인터럽트를 끄고 호출. */
+static void rwlock_hold(struct rwlock *rw)
+{
+   struct rwlock_hold *h = rwlock_find_hold(NULL);
+   int pri = -1;
+
+   if (h == NULL)
+      PANIC("thread holds more than %d rwlocks", RWLOCK_HOLD_MAX);
+   h->rwlock = rw;
+   h->thread = thread_current();
+   h->donation_bitmap = 0;
+   list_push_back(&rw->holders, &h->elem);
+
+   if (thread_mlfqs)
+      return;
+   if (!list_empty(&rw->read_waiters))
+      pri = list_entry(list_max(&rw->read_waiters, cmp_priority_max, NULL), struct thread, elem)->effective_priority;
+   if (!list_empty(&rw->write_waiters))
+   {
+      int wpri = list_entry(list_max(&rw->write_waiters, cmp_priority_max, NULL), struct thread, elem)->effective_priority;
+      if (wpri > pri)
+         pri = wpri;
+   }
+   if (pri >= 0)
+      rwlock_hold_donate(h, pri);
+}
+
+/* 현재 쓰레드의 RW hold를 지우고 그 hold로 받은 기부를 회수한다.
+   기다리는 writer가 있으면 가장 높은 writer 하나를, 없으면 reader 전부를
+   깨운다 (RW가 완전히 풀렸을 때만).  인터럽트를 끄고 호출. */
+static void rwlock_unhold(struct rwlock *rw)
+{
+   struct rwlock_hold *h = rwlock_find_hold(rw);
+   struct list_elem *e;
+
+   ASSERT(h != NULL);
+   list_remove(&h->elem);
+   h->rwlock = NULL;
+   if (h->donation_bitmap != 0)
+      collect_donations(h->thread);
+
+   if (rw->readers > 0 || rw->writer != NULL)
+      return;
+   if (!list_empty(&rw->write_waiters))
+   {
+      e = list_max(&rw->write_waiters, cmp_priority_max, NULL);
+      list_remove(e);
+      thread_unblock(list_entry(e, struct thread, elem));
+   }
+   else
+      while (!list_empty(&rw->read_waiters))
+         thread_unblock(list_entry(list_pop_front(&rw->read_waiters), struct thread, elem));
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   waits for it.  The current thread must not hold RW already.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_read_acquire(struct rwlock *rw)
+{
+   enum intr_level old_level;
+
+   ASSERT(rw != NULL);
+   ASSERT(!intr_context());
+   ASSERT(!rwlock_held_by_current_thread(rw));
+
+   old_level = intr_disable();
+   while (rw->writer != NULL || rw->waiting_writers > 0)
+      rwlock_wait(rw, &rw->read_waiters);
+   rw->readers++;
+   rwlock_hold(rw);
+   intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading. */
+void rwlock_read_release(struct rwlock *rw)
+{
+   enum intr_level old_level;
+
+   ASSERT(rw != NULL);
+   ASSERT(rwlock_held_by_current_thread(rw) && rw->writer == NULL);
+
+   old_level = intr_disable();
+   rw->readers--;
+   rwlock_unhold(rw);
+   thread_yield();
+   intr_set_level(old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not hold RW already.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_write_acquire(struct rwlock *rw)
+{
+   enum intr_level old_level;
+
+   ASSERT(rw != NULL);
+   ASSERT(!intr_context());
+   ASSERT(!rwlock_held_by_current_thread(rw));
+
+   old_level = intr_disable();
+   rw->waiting_writers++;
+   while (rw->writer != NULL || rw->readers > 0)
+      rwlock_wait(rw, &rw->write_waiters);
+   rw->waiting_writers--;
+   rw->writer = thread_current();
+   rwlock_hold(rw);
+   intr_set_level(old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void rwlock_write_release(struct rwlock *rw)
+{
+   enum intr_level old_level;
+
+   ASSERT(rw != NULL);
+   ASSERT(rw->writer == thread_current());
+
+   old_level = intr_disable();
+   rw->writer = NULL;
+   rwlock_unhold(rw);
+   thread_yield();
+   intr_set_level(old_level);
+}
+
+/* Returns true if the current thread holds RW, for reading or
+   for writing. */
+bool rwlock_held_by_current_thread(const struct rwlock *rw)
+{
+   ASSERT(rw != NULL);
+
+   return rwlock_find_hold(rw) != NULL;
 }
 
 /* One semaphore in a list. */
@@ -455,11 +925,58 @@ void cond_wait(struct condition *cond, struct lock *lock)
    lock_acquire(lock);
 }
 
+/* Like cond_wait(), but gives up waiting after TICKS timer ticks.
+   LOCK is reacquired either way.  Returns true if COND was
+   signaled, false on timeout. */
+bool cond_wait_timeout(struct condition *cond, struct lock *lock, int64_t ticks)
+{
+   struct semaphore_elem waiter;
+   bool signaled;
+
+   ASSERT(cond != NULL);
+   ASSERT(lock != NULL);
+   ASSERT(!intr_context());
+   ASSERT(lock_held_by_current_thread(lock));
+
+   sema_init(&waiter.semaphore, 0);
+   list_push_back(&cond->waiters, &waiter.elem);
+
+   lock_release(lock);
+   signaled = sema_down_timeout(&waiter.semaphore, ticks);
+
+   lock_acquire(lock);
+   /* 시간이 다 된 뒤 LOCK을 다시 잡기 전에 신호를 받았을 수 있다.
+      받지 않았다면 LOCK을 잡고 있으므로 안전하게 목록에서 뺄 수 있다. */
+   if (!signaled)
+   {
+      if (sema_try_down(&waiter.semaphore))
+         signaled = true;
+      else
+         list_remove(&waiter.elem);
+   }
+   return signaled;
+}
+
+/* 대기 중인 쓰레드가 없는 (시간이 다 된) 조건 변수 waiter의 우선순위. */
+static int cond_waiter_priority(struct semaphore *s)
+{
+   if (list_empty(&s->waiters))
+      return PRI_MIN - 1;
+   return list_entry(list_front(&s->waiters), struct thread, elem)->effective_priority;
+}
+
 bool cmp_cond_max(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
 {
-   const struct semaphore *s1 = &list_entry(a_, struct semaphore_elem, elem)->semaphore;
-   const struct semaphore *s2 = &list_entry(b_, struct semaphore_elem, elem)->semaphore;
-   return (thread_get_priority_manual(list_entry(list_front(&s1->waiters), struct thread, elem)) < thread_get_priority_manual(list_entry(list_front(&s2->waiters), struct thread, elem)));
+   struct semaphore *s1 = &list_entry(a_, struct semaphore_elem, elem)->semaphore;
+   struct semaphore *s2 = &list_entry(b_, struct semaphore_elem, elem)->semaphore;
+   return cond_waiter_priority(s1) < cond_waiter_priority(s2);
+}
+
+/* 우선순위 내림차순 정렬용.  list_sort()는 안정 정렬이므로 같은
+   우선순위끼리는 기다리기 시작한 순서가 유지된다. */
+static bool cmp_cond_desc(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
+{
+   return cmp_cond_max(b_, a_, NULL);
 }
 
 /* If any threads are waiting on COND (protected by LOCK), then
@@ -509,9 +1026,112 @@ void cond_signal(struct condition *cond, struct lock *lock UNUSED)
    내에서 조건 변수를 신호하는 것은 의미가 없습니다." */
 void cond_broadcast(struct condition *cond, struct lock *lock)
 {
+   enum intr_level old_level;
+   int max_pri = PRI_MIN - 1;
+
    ASSERT(cond != NULL);
    ASSERT(lock != NULL);
+   ASSERT(!intr_context());
+   ASSERT(lock_held_by_current_thread(lock));
+
+   if (list_empty(&cond->waiters))
+      return;
 
+   /* cond_signal()을 N번 부르면 매번 list_max()로 O(N^2)이고 매번
+      양보한다.  한 번 정렬한 뒤 인터럽트를 끈 채 모두 실행 큐에
+      넣고, 필요하면 마지막에 한 번만 양보한다.  깨우는 순서는 cond_signal()을
+      반복한 것과 같다. */
+   old_level = intr_disable();
+   list_sort(&cond->waiters, cmp_cond_desc, NULL);
    while (!list_empty(&cond->waiters))
-      cond_signal(cond, lock);
-}
\ No newline at end of file
+   {
+      struct list_elem *e = list_pop_front(&cond->waiters);
+      int pri = sema_wake(&list_entry(e, struct semaphore_elem, elem)->semaphore);
+      if (pri > max_pri)
+         max_pri = pri;
+   }
+   /* 깨운 쓰레드 중 나보다 높은 게 있을 때만 양보한다. */
+   if (max_pri > thread_get_priority())
+      thread_yield();
+   intr_set_level(old_level);
+}
+/* Initializes spinlock SL.  A spinlock is held by a CPU rather
+   than by a thread, and is for the short critical sections that
+   the scheduler itself runs in, where sleeping is not an option.
+
+   스핀락은 쓰레드가 아니라 CPU가 잡는다.  잡고 있는 동안 인터럽트는
+   꺼져 있어야 한다 (같은 CPU에서 선점되면 다시 잡으려다 데드락). */
+void spinlock_init(struct spinlock *sl)
+{
+   ASSERT(sl != NULL);
+
+   sl->locked = 0;
+   sl->holder = NULL;
+#ifdef LOCKSTAT
+   sl->stat = lockstat_site(__builtin_return_address(0));
+#endif
+}
+
+/* Names SL for the lock profiler, like lock_set_name().  NAME
+   must be a string that lives forever.  Does nothing unless the
+   kernel is built with LOCKSTAT. */
+void spinlock_set_name(struct spinlock *sl UNUSED, const char *name UNUSED)
+{
+#ifdef LOCKSTAT
+   sl->stat = lockstat_named(name);
+#endif
+}
+
+/* Acquires SL, spinning until it is available.  Interrupts must
+   be off, and SL must not already be held by the current CPU. */
+void spinlock_acquire(struct spinlock *sl)
+{
+   ASSERT(sl != NULL);
+   ASSERT(intr_get_level() == INTR_OFF);
+   ASSERT(!spinlock_held_by_current_cpu(sl));
+
+#ifdef LOCKSTAT
+   if (xchg(&sl->locked, 1) != 0)
+   {
+      uint64_t start = rdtsc();
+
+      while (xchg(&sl->locked, 1) != 0)
+         while (sl->locked)
+            cpu_relax();
+      __atomic_add_fetch(&sl->stat->contended, 1, __ATOMIC_RELAXED);
+      __atomic_add_fetch(&sl->stat->wait_cycles, rdtsc() - start, __ATOMIC_RELAXED);
+   }
+   __atomic_add_fetch(&sl->stat->acquired, 1, __ATOMIC_RELAXED);
+   sl->acquired_tsc = rdtsc();
+#else
+   /* 읽기만 하며 돌다가 풀렸을 때만 xchg로 버스를 잡는다. */
+   while (xchg(&sl->locked, 1) != 0)
+      while (sl->locked)
+         cpu_relax();
+#endif
+   sl->holder = cpu_current();
+}
+
+/* Releases SL, which must be held by the current CPU. */
+void spinlock_release(struct spinlock *sl)
+{
+   ASSERT(sl != NULL);
+   ASSERT(spinlock_held_by_current_cpu(sl));
+
+#ifdef LOCKSTAT
+   uint64_t hold = rdtsc() - sl->acquired_tsc;
+
+   if (hold > sl->stat->hold_max_cycles)
+      sl->stat->hold_max_cycles = hold;
+#endif
+   sl->holder = NULL;
+   xchg(&sl->locked, 0);
+}
+
+/* Returns true if the current CPU holds SL, false otherwise. */
+bool spinlock_held_by_current_cpu(const struct spinlock *sl)
+{
+   ASSERT(sl != NULL);
+
+   return sl->locked && sl->holder == cpu_current();
+}
@@ -4,14 +4,18 @@
 #include <random.h>
 #include <stdio.h>
 #include <string.h>
+#include "devices/timer.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
+#include "threads/rcu.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
 #ifdef USERPROG
+#include "userprog/fpu.h"
 #include "userprog/process.h"
 #endif
 
@@ -24,21 +28,14 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running.
+/* Lists of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running, are kept per
+   CPU in struct cpu (threads/cpu.h).  A READY thread sits in the
+   run queue of t->cpu. */
 
-   for mlfqs */
-static struct list ready_list[64];
-
-/* All threads */
+/* All threads, including the idle threads. */
 static struct list all_list;
 
-/*sleep List*/
-static struct list sleep_list;
-
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
@@ -55,24 +52,65 @@ static long long user_ticks;   /* # of timer ticks in user programs. */
 
 /* Scheduling. */
 #define TIME_SLICE 4		  /* # of timer ticks to give each thread. */
-static unsigned thread_ticks; /* # of timer ticks since last yield. */
+#define BALANCE_INTERVAL 20	  /* # of timer ticks between rebalances. */
 
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, voluntary switches save the whole intr_frame. */
+bool thread_switch_full;
+
+void switch_threads(uint64_t *cur_sp, uint64_t *next_sp,
+					struct intr_frame *next_tf);
+
 /* mlfq용 변수 선언 */
 static int ready_threads;
 static int load_avg;
 
+/* recent_cpu 감쇠(1초마다)를 BLOCKED 쓰레드에는 늦게 적용한다.
+   decay_epoch는 지금까지 적용된 감쇠 횟수이고, decay_coef에는
+   최근 DECAY_WINDOW번의 감쇠 계수 (2*load_avg)/(2*load_avg+1)가 남는다.
+   decay_list에는 BLOCKED 쓰레드가 recent_epoch 오름차순으로 들어있다. */
+#define DECAY_WINDOW 64
+static int decay_coef[DECAY_WINDOW];
+static int64_t decay_epoch;
+static struct list decay_list;
+
+/* 마감(EDF) 클래스.  dl_bw는 승인된 마감 쓰레드들의 runtime/period
+   합이다 (DL_BW_ONE = 100%).  일반 쓰레드 몫으로 5%를 남긴다.
+   마감 쓰레드가 어느 CPU에 있든 한 CPU 몫으로 세므로, CPU가 여럿이면
+   필요한 것보다 적게 승인할 뿐 마감을 놓치게 하지는 않는다. */
+#define DL_BW_ONE (1 << 20)
+#define DL_BW_MAX (DL_BW_ONE * 95 / 100)
+static int64_t dl_bw;
+
 static void kernel_thread(thread_func *, void *aux);
 static void idle(void *aux UNUSED);
+static void idle_loop(struct thread *idle_thread) NO_RETURN;
+static tid_t create_thread(const char *name, int priority, thread_func *,
+						   void *aux, bool bound);
 static struct thread *next_thread_to_run(void);
 static void init_thread(struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule(void);
 static tid_t allocate_tid(void);
+static void ready_push(struct thread *t);
+static void rq_push(struct cpu *c, struct thread *t);
+static void rq_remove(struct cpu *c, struct thread *t);
+static struct thread *rq_pop(struct cpu *c);
+static struct cpu *rq_lock_thread(struct thread *t);
+static bool steal_work(struct cpu *self);
+static void rebalance(struct cpu *self);
+static void mlfqs_decay(struct thread *t);
+static void mlfqs_update_priority(struct thread *t);
+static void dl_refresh(struct thread *t, int64_t now);
+static void dl_charge(struct thread *t);
+static bool dl_preempts(struct thread *t);
+static void dl_replenish(void *t_);
+static void dl_leave(struct thread *t);
+static void account_switch(struct thread *curr, struct thread *next);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -84,6 +122,9 @@ static tid_t allocate_tid(void);
  * somewhere in the middle, this locates the curent thread. */
 #define running_thread() ((struct thread *)(pg_round_down(rrsp())))
 
+/* 0이 아닌 64비트 워드에서 가장 높은 set bit의 위치 (bsr 한 번) */
+#define highest_bit(x) (63 - __builtin_clzll(x))
+
 /* 고정 소수점 계산 매크로 f = 2^14 */
 #define f 16384
 
@@ -149,13 +190,14 @@ void thread_init(void)
 
 	/* Init the globla thread context */
 	lock_init(&tid_lock);
-	for (int i = 0; i < 64; i++)
-		list_init(&ready_list[i]);
-	list_init(&sleep_list);
+	lock_set_name(&tid_lock, "tid");
+	thread_init_cpu(&cpus[0]);
 	list_init(&destruction_req);
 
 	/* mlfq용 모든 쓰레드 연결 리스트 초기화 */
 	list_init(&all_list);
+	list_init(&decay_list);
+	decay_epoch = 0;
 
 	/* 1분간 Running, Ready 상태였던 쓰레드의 추정치 */
 	load_avg = 0;
@@ -165,10 +207,25 @@ void thread_init(void)
 	/* Set up a thread structure for the running thread. */
 	initial_thread = running_thread();
 	init_thread(initial_thread, "main", PRI_DEFAULT);
+	initial_thread->cpu = &cpus[0];
+	cpus[0].started = true;
+	cpus[0].online = true;
+	cpus[0].running = initial_thread;
 	initial_thread->status = THREAD_RUNNING;
 	initial_thread->tid = allocate_tid();
 }
 
+/* Initializes C's run queue. */
+void thread_init_cpu(struct cpu *c)
+{
+	for (int i = PRI_MIN; i <= PRI_MAX; i++)
+		list_init(&c->ready_list[i]);
+	c->ready_bitmap = 0;
+	c->ready_cnt = 0;
+	list_init(&c->dl_list);
+	spinlock_init(&c->rq_lock);
+}
+
 /* Starts preemptive thread scheduling by enabling interrupts.
    Also creates the idle thread.
 
@@ -178,7 +235,7 @@ void thread_start(void)
 	/* Create the idle thread. */
 	struct semaphore idle_started;
 	sema_init(&idle_started, 0);
-	thread_create("idle", PRI_MIN, idle, &idle_started);
+	thread_create("idle0", PRI_MIN, idle, &idle_started);
 
 	/* Start preemptive thread scheduling. */
 	intr_enable();
@@ -187,15 +244,56 @@ void thread_start(void)
 	sema_down(&idle_started);
 }
 
+/* Creates the idle thread of application processor C, whose
+   page the AP will also boot on.  Called by cpu_start_aps() on
+   the BSP, since init_thread() needs a running thread to inherit
+   from.  Returns NULL if out of memory. */
+struct thread *
+thread_create_idle(struct cpu *c)
+{
+	struct thread *t;
+	char name[16];
+
+	t = palloc_get_page(PAL_ZERO);
+	if (t == NULL)
+		return NULL;
+
+	snprintf(name, sizeof name, "idle%d", c->id);
+	init_thread(t, name, PRI_MIN);
+	t->tid = allocate_tid();
+	t->cpu = c;
+	if (thread_mlfqs)
+		t->priority = t->effective_priority = PRI_MIN;
+	c->idle_thread = t;
+	return t;
+}
+
+/* Turns the code that AP C is running into its idle thread,
+   which from then on runs C's threads.  Called from
+   cpu.c:ap_main() with interrupts off, once C is online. */
+void thread_start_ap(struct cpu *c)
+{
+	struct thread *t = running_thread();
+
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t == c->idle_thread);
+	ASSERT(c->online);
+
+	t->status = THREAD_RUNNING;
+	c->running = t;
+	idle_loop(t);
+}
+
 /* Called by the timer interrupt handler at each timer tick.
    Thus, this function runs in an external interrupt context.
    타이머 인터럽트 핸들러에 의해 각 타이머 틱마다 호출됩니다. 따라서 이 함수는 외부 인터럽트 컨텍스트에서 실행됩니다. */
 void thread_tick(void)
 {
 	struct thread *t = thread_current();
+	struct cpu *c = t->cpu;
 
 	/* Update statistics. */
-	if (t == idle_thread)
+	if (t == c->idle_thread)
 		idle_ticks++;
 #ifdef USERPROG
 	else if (t->pml4 != NULL)
@@ -204,16 +302,27 @@ void thread_tick(void)
 	else
 		kernel_ticks++;
 
-	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
+	/* Enforce preemption.  마감 쓰레드는 time slice 대신 예산을 쓴다. */
+	if (t->dl_runtime > 0 && t->dl_budget > 0)
+		dl_charge(t);
+	else if (++c->thread_ticks >= TIME_SLICE)
 		intr_yield_on_return();
+
+	rcu_tick();
+
+	/* 주기적으로 다른 CPU와 부하를 맞춘다. */
+	if (++c->balance_ticks >= BALANCE_INTERVAL)
+	{
+		c->balance_ticks = 0;
+		rebalance(c);
+	}
 }
 
 /* current_thread의 recent_cpu 1 증가 (1틱마다) */
 void thread_recent_cpu_incr(void)
 {
 	struct thread *t = thread_current();
-	if (t != idle_thread)
+	if (t != t->cpu->idle_thread)
 		t->recent_cpu = add_fix(t->recent_cpu, 1);
 }
 
@@ -223,21 +332,180 @@ void thread_calc_load(void)
 	load_avg = multiply_fix(divide_fix(to_fix(59), to_fix(60)), load_avg) + divide_fix(to_fix(1), to_fix(60)) * ready_threads;
 }
 
-/* 모든 쓰레드의 recent_cpu 갱신 (100틱마다) */
+/* recent_cpu 감쇠 (100틱마다)
+   실행 중인 쓰레드와 READY 쓰레드만 바로 감쇠하고 우선순위를 다시 계산한다.
+   BLOCKED 쓰레드는 thread_unblock() 때 밀린 감쇠를 한꺼번에 적용하며,
+   계수가 창 밖으로 밀려나기 직전의 쓰레드만 여기서 따라잡게 한다. */
 void thread_calc_recent_cpu(void)
 {
-	for (struct list_elem *cur = list_begin(&all_list); cur != list_end(&all_list); cur = list_next(cur))
+	struct thread *curr = thread_current();
+	struct list_elem *e;
+	struct cpu *c;
+	int pri;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	while (!list_empty(&decay_list))
+	{
+		struct thread *t = list_entry(list_front(&decay_list), struct thread, decay_elem);
+		if (decay_epoch - t->recent_epoch < DECAY_WINDOW)
+			break;
+		mlfqs_decay(t);
+		list_push_back(&decay_list, list_pop_front(&decay_list));
+	}
+
+	decay_epoch++;
+	decay_coef[decay_epoch % DECAY_WINDOW] = divide_fix((2 * load_avg), (add_fix((2 * load_avg), 1)));
+
+	if (curr != curr->cpu->idle_thread)
+		mlfqs_decay(curr);
+
+	/* 옮겨진 쓰레드를 다시 만나도 mlfqs_decay()는 아무 일도 하지 않는다. */
+	for (c = cpus; c < cpus + cpu_cnt; c++)
 	{
-		struct thread *t = list_entry(cur, struct thread, all_elem);
-		t->recent_cpu = add_fix((multiply_fix(divide_fix((2 * load_avg), (add_fix((2 * load_avg), 1))), t->recent_cpu)), t->nice);
+		spinlock_acquire(&c->rq_lock);
+		for (pri = PRI_MAX; pri >= PRI_MIN; pri--)
+			for (e = list_begin(&c->ready_list[pri]); e != list_end(&c->ready_list[pri]);)
+			{
+				struct thread *t = list_entry(e, struct thread, elem);
+				e = list_next(e);
+				mlfqs_decay(t);
+				mlfqs_update_priority(t);
+				if (t->ready_pri != t->effective_priority)
+				{
+					rq_remove(c, t);
+					rq_push(c, t);
+				}
+			}
+		spinlock_release(&c->rq_lock);
 	}
 }
 
+/* T의 recent_cpu에 아직 적용하지 않은 감쇠를 순서대로 적용한다. */
+static void
+mlfqs_decay(struct thread *t)
+{
+	ASSERT(decay_epoch - t->recent_epoch <= DECAY_WINDOW);
+
+	while (t->recent_epoch < decay_epoch)
+	{
+		int coef = decay_coef[++t->recent_epoch % DECAY_WINDOW];
+		t->recent_cpu = add_fix(multiply_fix(coef, t->recent_cpu), t->nice);
+	}
+}
+
+/* T의 recent_cpu와 nice로 우선순위를 다시 계산한다.  mlfqs에는 기부가 없으므로
+   effective_priority도 같은 값이다.
+   READY 쓰레드의 큐 이동은 호출자 몫이다 (thread_calc_recent_cpu()만 해당). */
+static void
+mlfqs_update_priority(struct thread *t)
+{
+	t->priority = PRI_MAX - fix_to_int((t->recent_cpu / 4)) - (t->nice * 2);
+	if (t->priority < PRI_MIN)
+		t->priority = PRI_MIN;
+	if (t->priority > PRI_MAX)
+		t->priority = PRI_MAX;
+	t->effective_priority = t->priority;
+}
+
 /* Prints thread statistics. 스레드 통계를 출력합니다. */
 void thread_print_stats(void)
 {
 	printf("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
 		   idle_ticks, kernel_ticks, user_ticks);
+	palloc_print_stats();
+}
+
+/* 쓰레드 상태 이름 (thread_print_all_stats용). */
+static const char *thread_status_name[] = {"RUN", "READY", "BLOCK", "DYING"};
+
+/* Copies the statistics of the thread whose id is TID, or of the
+   running thread if TID is 0, into *STATS.  The running thread's
+   current time slice is included in run_ns.  Returns false if
+   there is no such thread. */
+bool thread_get_stats(tid_t tid, struct thread_stats *stats)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	struct list_elem *e;
+	bool found = false;
+
+	old_level = intr_disable();
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, all_elem);
+
+		if (t->tid != tid && !(tid == 0 && t == curr))
+			continue;
+		*stats = t->stats;
+		if (t == curr)
+			stats->run_ns += timer_ns() - t->stats_stamp;
+		found = true;
+		break;
+	}
+	intr_set_level(old_level);
+	return found;
+}
+
+/* thread_print_all_stats()가 한꺼번에 찍어 두는 쓰레드 하나. */
+struct thread_snapshot
+{
+	tid_t tid;
+	char name[16];
+	enum thread_status status;
+	struct thread_stats stats;
+};
+
+/* Prints the statistics of every thread, one per line.  Used by
+   the `ps' action of init.c. */
+void thread_print_all_stats(void)
+{
+	struct thread_snapshot *snap;
+	enum intr_level old_level;
+	struct list_elem *e;
+	size_t cnt = 0, more = 0, i;
+
+	/* printf()는 잠들 수 있으므로 인터럽트를 끈 채 한 페이지에 찍어 둔다. */
+	snap = palloc_get_page(0);
+	if (snap == NULL)
+		return;
+
+	old_level = intr_disable();
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, all_elem);
+		struct thread_snapshot *s = &snap[cnt];
+
+		if (cnt == PGSIZE / sizeof *snap)
+		{
+			more++;
+			continue;
+		}
+		s->tid = t->tid;
+		strlcpy(s->name, t->name, sizeof s->name);
+		s->status = t->status;
+		s->stats = t->stats;
+		if (t == thread_current())
+			s->stats.run_ns += timer_ns() - t->stats_stamp;
+		cnt++;
+	}
+	intr_set_level(old_level);
+
+	printf("%5s %-16s %-5s %10s %10s %10s %10s %8s %8s %8s\n",
+		   "TID", "NAME", "STATE", "RUN(us)", "READY(us)", "MAXRDY(us)",
+		   "LOCK(us)", "DISPATCH", "VOL", "INVOL");
+	for (i = 0; i < cnt; i++)
+	{
+		struct thread_stats *st = &snap[i].stats;
+
+		printf("%5d %-16s %-5s %10lld %10lld %10lld %10lld %8llu %8llu %8llu\n",
+			   snap[i].tid, snap[i].name, thread_status_name[snap[i].status],
+			   st->run_ns / 1000, st->ready_ns / 1000, st->ready_max_ns / 1000,
+			   st->lock_ns / 1000, st->dispatches, st->voluntary, st->involuntary);
+	}
+	if (more > 0)
+		printf("(%zu more threads not shown)\n", more);
+	palloc_free_page(snap);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -270,6 +538,23 @@ void thread_print_stats(void)
 
 tid_t thread_create(const char *name, int priority,
 					thread_func *function, void *aux)
+{
+	return create_thread(name, priority, function, aux, false);
+}
+
+/* Like thread_create(), but the new thread runs on cpu0 only.
+   For threads that will run user programs, which need cpu0's TSS
+   and syscall entry (see cpu.c). */
+tid_t thread_create_bound(const char *name, int priority,
+						  thread_func *function, void *aux)
+{
+	return create_thread(name, priority, function, aux, true);
+}
+
+/* thread_create()와 thread_create_bound()의 본체. */
+static tid_t
+create_thread(const char *name, int priority, thread_func *function,
+			  void *aux, bool bound)
 {
 	struct thread *t;
 	tid_t tid;
@@ -284,6 +569,8 @@ tid_t thread_create(const char *name, int priority,
 	/* Initialize thread. */
 	init_thread(t, name, priority);
 	tid = t->tid = allocate_tid();
+	t->bound = bound;
+	t->cpu = bound ? &cpus[0] : thread_current()->cpu;
 
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
@@ -294,7 +581,9 @@ tid_t thread_create(const char *name, int priority,
 	t->tf.es = SEL_KDSEG;
 	t->tf.ss = SEL_KDSEG;
 	t->tf.cs = SEL_KCSEG;
-	t->tf.eflags = FLAG_IF;
+	/* 스케줄러가 잡은 커널 락을 넘겨받도록 인터럽트를 끈 채 시작한다.
+	   kernel_thread()가 켠다. */
+	t->tf.eflags = FLAG_MBS;
 
 	/* Add to run queue. */
 	thread_unblock(t);
@@ -318,10 +607,13 @@ void thread_block(void)
 	ASSERT(intr_get_level() == INTR_OFF);
 
 	/* mlfq */
-	if (thread_current() != idle_thread && thread_mlfqs)
+	if (thread_current() != cpu_current()->idle_thread && thread_mlfqs)
 	{
 		ready_threads--;
 		ASSERT(ready_threads >= 0);
+		/* 실행 중인 쓰레드는 항상 최신 epoch이므로 맨 뒤에 넣어도 정렬이 유지된다. */
+		list_push_back(&decay_list, &thread_current()->decay_elem);
+		thread_current()->decay_pending = true;
 	}
 	thread_current()->status = THREAD_BLOCKED;
 	schedule();
@@ -352,15 +644,23 @@ void thread_unblock(struct thread *t)
 
 	old_level = intr_disable();
 	ASSERT(t->status == THREAD_BLOCKED);
-	if (thread_mlfqs)
-		list_insert_ordered(&ready_list[t->priority], &t->elem, cmp_recent, NULL);
-	else
-		list_insert_ordered(&ready_list, &t->elem, cmp_priority, NULL);
-
+	if (t->decay_pending)
+	{
+		/* 자는 동안 밀린 recent_cpu 감쇠를 적용 */
+		list_remove(&t->decay_elem);
+		t->decay_pending = false;
+		mlfqs_decay(t);
+		mlfqs_update_priority(t);
+	}
+	ready_push(t);
 	t->status = THREAD_READY;
+	t->stats_stamp = timer_ns();
 	/* mlfq */
 	if (thread_mlfqs)
 		ready_threads++;
+	/* 인터럽트가 깨운 마감 쓰레드가 더 급하면 돌아가면서 양보한다. */
+	if (intr_context() && t->dl_queued && dl_preempts(t))
+		intr_yield_on_return();
 	intr_set_level(old_level);
 }
 
@@ -411,20 +711,21 @@ tid_t thread_tid(void)
 void thread_exit(void)
 {
 	ASSERT(!intr_context());
+	ASSERT(thread_current()->rcu_nesting == 0);
 
 #ifdef USERPROG
 	process_exit();
+	fpu_release(thread_current());
 #endif
 
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable();
+	dl_leave(thread_current());
+	list_remove(&thread_current()->all_elem);
 	/* mlfqs */
 	if (thread_mlfqs)
-	{
-		list_remove(&thread_current()->all_elem);
 		ready_threads--;
-	}
 	do_schedule(THREAD_DYING);
 	NOT_REACHED();
 }
@@ -441,73 +742,39 @@ void thread_yield(void)
 	ASSERT(!intr_context());
 
 	old_level = intr_disable();
-	if (curr != idle_thread)
+	if (curr != curr->cpu->idle_thread)
 	{
-		/* mlfqs */
-		if (thread_mlfqs)
-			list_insert_ordered(&ready_list[thread_get_priority()], &curr->elem, cmp_recent, NULL);
-		else
-			list_insert_ordered(&ready_list, &curr->elem, cmp_priority, NULL);
+		/* 문맥을 저장하기 전에 다른 CPU가 가져가지 못하게 표시한다. */
+		curr->cpu->switching = curr;
+		ready_push(curr);
 	}
 
 	do_schedule(THREAD_READY);
 	intr_set_level(old_level);
 }
 
-/*현재 쓰레드가 THREAD_READY 되어야 할 wakeTick을 설정하고
-block상태로 전환 밑 sleep_list에 추가 */
-void thread_sleep(int64_t ticks)
-{
-	struct thread *curr = thread_current();
-	enum intr_level old_level;
-	ASSERT(!intr_context());
-
-	old_level = intr_disable();
-
-	if (curr != idle_thread)
-	{
-		curr->wake_tick = ticks;
-		list_insert_ordered(&sleep_list, &curr->elem, cmp_wake_tick, NULL);
-	}
-	thread_block();
-	intr_set_level(old_level);
-}
-
-/*sleep_list 리스트에서 현재 ticks 보다 작은 wake_tick을 가진 쓰레드 ready 상태로 변경
-  ,ready_list로 이동*/
-void thread_wake(int64_t ticks)
-{
-	enum intr_level old_level;
-	ASSERT(intr_context());
-	old_level = intr_disable();
-
-	struct thread *curr;
-	while (!list_empty(&sleep_list))
-	{
-		curr = list_entry(list_front(&sleep_list), struct thread, elem);
-		if (curr->wake_tick <= ticks)
-		{
-			list_pop_front(&sleep_list);
-			thread_unblock(curr);
-		}
-		else
-			break;
-	}
-	intr_set_level(old_level);
-}
-
+/* READY 상태인 T의 우선순위가 바뀌었을 때 맞는 실행 큐로 옮긴다. */
 void thread_relocate_ready(struct thread *t)
 {
-	list_remove(&t->elem);
-	t->status = THREAD_BLOCKED;
-	thread_unblock(t);
+	ASSERT(intr_get_level() == INTR_OFF);
+	ASSERT(t->status == THREAD_READY);
+
+	struct cpu *c = rq_lock_thread(t);
+	rq_remove(c, t);
+	rq_push(c, t);
+	spinlock_release(&c->rq_lock);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void thread_set_priority(int new_priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(!thread_mlfqs);
+	old_level = intr_disable();
 	thread_current()->priority = new_priority;
+	thread_update_priority(thread_current());
+	intr_set_level(old_level);
 	/*더 높은 priority를 가진 thread가 들어오면 자원을 양도하기 위해
 	  일단 yield를 수행하고 readylist에서 가장 우선순위가 높은 thread부터
 	  실행한다. 자신이 우선순위가 가장 높은 경우 yield가 호출되어도 문맥 교환이
@@ -521,40 +788,37 @@ int thread_get_priority(void)
 	return thread_get_priority_manual(thread_current());
 }
 
+/* T의 (기부를 반영한) 유효 우선순위. */
 int thread_get_priority_manual(struct thread *t)
 {
-	if (thread_mlfqs)
-		return t->priority;
+	return t->effective_priority;
+}
 
-	if (t->donation_cnt == 0)
-		return t->priority;
-	else
-	{
-		int i = 63;
-		for (; i >= 0; i--)
-			if (t->donation_list[i] != 0)
-				break;
-		return i;
-	}
+/* T의 priority나 donation_bitmap이 바뀐 뒤 호출해서 effective_priority를
+   다시 계산한다.  READY 상태면 맞는 실행 큐로 옮긴다.  인터럽트를 끄고 호출. */
+void thread_update_priority(struct thread *t)
+{
+	int pri = t->priority;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (!thread_mlfqs && t->donation_bitmap != 0 && highest_bit(t->donation_bitmap) > pri)
+		pri = highest_bit(t->donation_bitmap);
+	t->effective_priority = pri;
+
+	if (t->status == THREAD_READY && !t->dl_queued && t->ready_pri != pri)
+		thread_relocate_ready(t);
 }
 
-/* mlfq 에서 쓰레드의 우선 순위 갱신 함수 */
+/* mlfq 에서 쓰레드의 우선 순위 갱신 함수 (4틱마다)
+   4틱 사이에 recent_cpu가 바뀌는 것은 실행 중인 쓰레드뿐이다.
+   나머지는 thread_calc_recent_cpu()와 thread_unblock()에서 갱신된다. */
 void thread_calc_priority(void)
 {
-	for (struct list_elem *cur = list_begin(&all_list); cur != list_end(&all_list); cur = list_next(cur))
-	{
-		struct thread *t = list_entry(cur, struct thread, all_elem);
-		t->priority = PRI_MAX - fix_to_int((t->recent_cpu / 4)) - (t->nice * 2);
-		if (t->priority < PRI_MIN)
-			t->priority = PRI_MIN;
-		if (t->priority > PRI_MAX)
-			t->priority = PRI_MAX;
-
-		if (t->status != THREAD_READY)
-			continue;
-		list_remove(&t->elem);
-		list_insert_ordered(&ready_list[t->priority], &t->elem, cmp_recent, NULL);
-	}
+	struct thread *curr = thread_current();
+
+	if (curr != curr->cpu->idle_thread)
+		mlfqs_update_priority(curr);
 }
 
 /* Sets the current thread's nice value to NICE. */
@@ -564,7 +828,7 @@ void thread_set_nice(int nice)
 	/* priority 갱신중  인터럽트 발생 */
 	old_level = intr_disable();
 	thread_current()->nice = nice;
-	thread_calc_priority();
+	mlfqs_update_priority(thread_current());
 	intr_set_level(old_level);
 	thread_yield();
 }
@@ -589,9 +853,9 @@ int thread_get_recent_cpu(void)
 
 /* Idle thread.  Executes when no other thread is ready to run.
 
-   The idle thread is initially put on the ready list by
+   The BSP's idle thread is initially put on the ready list by
    thread_start().  It will be scheduled once initially, at which
-   point it initializes idle_thread, "up"s the semaphore passed
+   point it initializes its CPU's idle_thread, "up"s the semaphore passed
    to it to enable thread_start() to continue, and immediately
    blocks.  After that, the idle thread never appears in the
    ready list.  It is returned by next_thread_to_run() as a
@@ -601,41 +865,44 @@ idle(void *idle_started_ UNUSED)
 {
 	struct semaphore *idle_started = idle_started_;
 
-	idle_thread = thread_current();
+	struct thread *idle_thread = thread_current();
+
+	idle_thread->cpu->idle_thread = idle_thread;
 	if (thread_mlfqs)
 	{
 		ready_threads--;
-		idle_thread->priority = 0;
-		list_remove(&idle_thread->all_elem);
+		idle_thread->priority = idle_thread->effective_priority = 0;
 	}
 	sema_up(idle_started);
+	idle_loop(idle_thread);
+}
 
+/* Body of every CPU's idle thread. */
+static void
+idle_loop(struct thread *idle_thread)
+{
 	for (;;)
 	{
 		/* Let someone else run. */
 		intr_disable();
 		thread_block();
+
+		/* 로컬 실행 큐가 비었다.  hlt 전에 다른 CPU에서 일을 훔쳐 본다. */
+		if (steal_work(idle_thread->cpu))
+			continue;
+		/* 다음 할 일이 있는 틱까지 타이머 인터럽트를 멈춘다. */
+		timer_idle_enter();
 		/* Re-enable interrupts and wait for the next one.
 
-		   The `sti' instruction disables interrupts until the
-		   completion of the next instruction, so these two
-		   instructions are executed atomically.  This atomicity is
-		   important; otherwise, an interrupt could be handled
-		   between re-enabling interrupts and waiting for the next
-		   one to occur, wasting as much as one clock tick worth of
-		   time.
+		   intr_halt() does so atomically; otherwise, an interrupt
+		   could be handled between re-enabling interrupts and
+		   waiting for the next one to occur, wasting as much as one
+		   clock tick worth of time.
 
 		   "인터럽트를 다시 활성화하고 다음 인터럽트를 기다립니다.
-
-		   'sti' 명령은 다음 명령의 완료까지 인터럽트를 비활성화하므로
-		   이 두 개의 명령은 원자적으로 실행됩니다. 이 원자성은 중요합니다.
-		   그렇지 않으면 인터럽트가 인터럽트를 다시 활성화하고 다음 인터럽트가
-		   발생하기를 기다리는 사이에 처리될 수 있으며, 이로 인해 1클럭 틱만큼의
-		   시간이 낭비될 수 있습니다."
-
-		   See [IA32-v2a] "HLT", [IA32-v2b] "STI", and [IA32-v3a]
-		   7.11.1 "HLT Instruction". */
-		asm volatile("sti; hlt" : : : "memory");
+		   원자적이지 않으면 그 사이에 처리된 인터럽트 때문에 1클럭 틱만큼의
+		   시간이 낭비될 수 있습니다." */
+		intr_halt();
 	}
 }
 
@@ -645,6 +912,7 @@ kernel_thread(thread_func *function, void *aux)
 {
 	ASSERT(function != NULL);
 
+	cpu_current()->switching = NULL; /* 이전 쓰레드의 문맥 저장이 끝났다. */
 	intr_enable(); /* The scheduler runs with interrupts off. */
 	function(aux); /* Execute the thread function. */
 	thread_exit(); /* If function() returns, kill the thread. */
@@ -655,6 +923,8 @@ kernel_thread(thread_func *function, void *aux)
 static void
 init_thread(struct thread *t, const char *name, int priority)
 {
+	enum intr_level old_level;
+
 	ASSERT(t != NULL);
 	ASSERT(PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT(name != NULL);
@@ -664,7 +934,7 @@ init_thread(struct thread *t, const char *name, int priority)
 	strlcpy(t->name, name, sizeof t->name);
 	t->tf.rsp = (uint64_t)t + PGSIZE - sizeof(void *);
 	if (!thread_mlfqs)
-		t->priority = priority;
+		t->priority = t->effective_priority = priority;
 	else
 	{
 		if (initial_thread == t)
@@ -677,43 +947,295 @@ init_thread(struct thread *t, const char *name, int priority)
 			t->nice = thread_current()->nice;
 			t->recent_cpu = thread_current()->recent_cpu;
 		}
-		t->priority = PRI_MAX - (fix_to_int((t->recent_cpu / 4))) - (t->nice * 2);
-		if (t->priority < PRI_MIN)
-			t->priority = PRI_MIN;
-		if (t->priority > PRI_MAX)
-			t->priority = PRI_MAX;
-		list_push_back(&all_list, &t->all_elem);
+		t->recent_epoch = decay_epoch;
+		mlfqs_update_priority(t);
 	}
+	old_level = intr_disable();
+	list_push_back(&all_list, &t->all_elem);
+	intr_set_level(old_level);
 	t->magic = THREAD_MAGIC;
 	t->wait_on_lock = NULL;
-	t->donation_cnt = 0;
-	for (int i = 0; i < 64; i++)
-		t->donation_list[i] = 0;
+	t->wait_on_rwlock = NULL;
+	t->donation_bitmap = 0;
+	list_init(&t->held_locks);
+	for (int i = 0; i < RWLOCK_HOLD_MAX; i++)
+		t->rw_holds[i].rwlock = NULL;
+	timeout_init(&t->dl_timer, dl_replenish, t);
+#ifdef USERPROG
+	t->leader = t;
+	list_init(&t->uthreads);
+	t->exiting = false;
+#endif
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
    will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   the CPU's idle thread. */
 
 static struct thread *next_thread_to_run(void)
 {
-	if (thread_mlfqs)
+	struct cpu *c = cpu_current();
+	struct thread *t;
+
+	spinlock_acquire(&c->rq_lock);
+	t = rq_pop(c);
+	spinlock_release(&c->rq_lock);
+
+	return t != NULL ? t : c->idle_thread;
+}
+
+/* T를 자기 CPU(t->cpu)의 실행 큐에 넣는다.  그 CPU가 다른 CPU이고
+   hlt 중이면 깨운다. */
+static void
+ready_push(struct thread *t)
+{
+	struct cpu *c = t->cpu;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	spinlock_acquire(&c->rq_lock);
+	rq_push(c, t);
+	spinlock_release(&c->rq_lock);
+
+	if (c->online && c != cpu_current() && c->idle_thread->status == THREAD_RUNNING)
+		cpu_kick(c);
+}
+
+/* 절대 마감이 빠른 순.  같으면 먼저 들어온 쪽이 앞에 남는다. */
+static bool
+dl_less(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
+{
+	const struct thread *a = list_entry(a_, struct thread, elem);
+	const struct thread *b = list_entry(b_, struct thread, elem);
+	return a->dl_start + a->dl_deadline < b->dl_start + b->dl_deadline;
+}
+
+/* T를 C의 현재 (유효) 우선순위 실행 큐 맨 뒤에 넣는다.
+   같은 우선순위끼리는 FIFO 순서로 실행된다.  이번 주기의 예산이 남은
+   마감 쓰레드는 대신 dl_list에 마감 순으로 넣는다.  rq_lock을 잡고 호출. */
+static void
+rq_push(struct cpu *c, struct thread *t)
+{
+	int pri = t->effective_priority;
+
+	ASSERT(spinlock_held_by_current_cpu(&c->rq_lock));
+	ASSERT(PRI_MIN <= pri && pri <= PRI_MAX);
+
+	if (t->dl_runtime > 0)
 	{
-		for (int i = PRI_MAX; i >= PRI_MIN; i--)
-			if (!list_empty(&ready_list[i]))
-				return list_entry(list_pop_front(&ready_list[i]), struct thread, elem);
+		dl_refresh(t, timer_ticks());
+		if (t->dl_budget > 0)
+		{
+			list_insert_ordered(&c->dl_list, &t->elem, dl_less, NULL);
+			t->dl_queued = true;
+			return;
+		}
+	}
+
+	t->ready_pri = pri;
+	list_push_back(&c->ready_list[pri], &t->elem);
+	c->ready_bitmap |= 1ULL << pri;
+	c->ready_cnt++;
+}
+
+/* C의 실행 큐에서 T를 뺀다.  큐가 비면 비트도 내린다. */
+static void
+rq_remove(struct cpu *c, struct thread *t)
+{
+	ASSERT(spinlock_held_by_current_cpu(&c->rq_lock));
 
-		return idle_thread;
+	list_remove(&t->elem);
+	if (t->dl_queued)
+	{
+		t->dl_queued = false;
+		return;
 	}
-	else
+	if (list_empty(&c->ready_list[t->ready_pri]))
+		c->ready_bitmap &= ~(1ULL << t->ready_pri);
+	c->ready_cnt--;
+}
+
+/* C에서 가장 높은 우선순위 실행 큐의 맨 앞 쓰레드를 꺼낸다.
+   마감 쓰레드가 있으면 마감이 가장 빠른 쓰레드가 먼저다.
+   READY 쓰레드가 없으면 NULL. */
+static struct thread *
+rq_pop(struct cpu *c)
+{
+	struct thread *t;
+	int pri;
+
+	ASSERT(spinlock_held_by_current_cpu(&c->rq_lock));
+
+	if (!list_empty(&c->dl_list))
 	{
-		if (list_empty(&ready_list))
-			return idle_thread;
-		else
-			return list_entry(list_pop_front(&ready_list), struct thread, elem);
+		t = list_entry(list_pop_front(&c->dl_list), struct thread, elem);
+		t->dl_queued = false;
+		return t;
 	}
+	if (c->ready_bitmap == 0)
+		return NULL;
+
+	pri = highest_bit(c->ready_bitmap);
+	t = list_entry(list_pop_front(&c->ready_list[pri]), struct thread, elem);
+	if (list_empty(&c->ready_list[pri]))
+		c->ready_bitmap &= ~(1ULL << pri);
+	c->ready_cnt--;
+	return t;
+}
+
+/* READY 쓰레드 T가 들어있는 실행 큐의 락을 잡고 그 CPU를 반환한다.
+   락을 기다리는 사이 T가 다른 CPU로 옮겨갈 수 있으므로 다시 확인한다. */
+static struct cpu *
+rq_lock_thread(struct thread *t)
+{
+	for (;;)
+	{
+		struct cpu *c = t->cpu;
+
+		spinlock_acquire(&c->rq_lock);
+		if (t->cpu == c)
+			return c;
+		spinlock_release(&c->rq_lock);
+	}
+}
+
+/* 두 CPU의 실행 큐 락을 id 순서대로 잡는다 (교착 방지). */
+static void
+rq_lock_pair(struct cpu *a, struct cpu *b)
+{
+	ASSERT(a != b);
+
+	if (a->id > b->id)
+	{
+		struct cpu *tmp = a;
+		a = b;
+		b = tmp;
+	}
+	spinlock_acquire(&a->rq_lock);
+	spinlock_acquire(&b->rq_lock);
+}
+
+static void
+rq_unlock_pair(struct cpu *a, struct cpu *b)
+{
+	spinlock_release(&a->rq_lock);
+	spinlock_release(&b->rq_lock);
+}
+
+/* SELF를 뺀 CPU 중에서 가장 높은 우선순위의 READY 쓰레드를 가진 CPU를
+   고르고, 그 우선순위를 *TOP에 담는다.  같으면 READY가 더 많은 쪽.
+   락 없이 읽은 값이라 힌트일 뿐이며, 훔칠 때 락을 잡고 다시 확인한다.
+   훔칠 쓰레드가 없으면 NULL.  쓰레드를 돌리는 (online) CPU만 본다. */
+static struct cpu *
+find_busiest(struct cpu *self, int *top)
+{
+	struct cpu *busiest = NULL;
+	struct cpu *c;
+
+	*top = -1;
+	for (c = cpus; c < cpus + cpu_cnt; c++)
+	{
+		uint64_t bitmap = c->ready_bitmap;
+		int pri;
+
+		if (c == self || !c->online || bitmap == 0)
+			continue;
+		pri = highest_bit(bitmap);
+		if (pri > *top || (pri == *top && c->ready_cnt > busiest->ready_cnt))
+		{
+			busiest = c;
+			*top = pri;
+		}
+	}
+	return busiest;
+}
+
+/* VICTIM의 우선순위 TOP 실행 큐에서 쓰레드 하나를 SELF로 옮긴다.
+   두 CPU의 락을 잡고 호출.  VICTIM의 가장 높은 우선순위가 그새 TOP이
+   아니게 됐다면 아무것도 옮기지 않는다 (더 높은 쓰레드를 두고 낮은
+   쓰레드를 가져오지 않기 위해).  문맥을 저장하는 중인 쓰레드와 CPU에
+   묶인 쓰레드는 건너뛴다.  옮긴 쓰레드를 반환한다. */
+static struct thread *
+migrate_one(struct cpu *self, struct cpu *victim, int top)
+{
+	struct list_elem *e;
+
+	if (victim->ready_bitmap == 0 || highest_bit(victim->ready_bitmap) != top)
+		return NULL;
+
+	for (e = list_begin(&victim->ready_list[top]); e != list_end(&victim->ready_list[top]);
+		 e = list_next(e))
+	{
+		struct thread *t = list_entry(e, struct thread, elem);
+
+		if (t == victim->switching || t->bound)
+			continue;
+		rq_remove(victim, t);
+		t->cpu = self;
+		rq_push(self, t);
+		return t;
+	}
+	return NULL;
+}
+
+/* 실행 큐가 빈 SELF가 다른 CPU에서 READY 쓰레드 하나를 훔쳐 온다.
+   가장 높은 우선순위의 쓰레드가 기다리는 CPU에서만 가져오므로, 어디선가
+   더 높은 쓰레드가 기다리는 동안 낮은 쓰레드를 가져오는 일은 없다.
+   훔쳤으면 true. */
+static bool
+steal_work(struct cpu *self)
+{
+	struct cpu *victim;
+	struct thread *t = NULL;
+	int top;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	victim = find_busiest(self, &top);
+	if (victim == NULL)
+		return false;
+
+	rq_lock_pair(self, victim);
+	if (self->ready_bitmap == 0)
+		t = migrate_one(self, victim, top);
+	rq_unlock_pair(self, victim);
+	return t != NULL;
+}
+
+/* 주기적 재분배 (thread_tick에서 BALANCE_INTERVAL틱마다).
+   다른 CPU에서 SELF가 실행 중인 쓰레드보다 높은 우선순위의 쓰레드가
+   기다리고 있거나, 같은 우선순위 쓰레드가 SELF보다 2개 이상 많이
+   기다리고 있으면 하나를 가져온다.  가져온 쓰레드가 더 높으면 양보한다. */
+static void
+rebalance(struct cpu *self)
+{
+	struct thread *curr = thread_current();
+	struct thread *t = NULL;
+	struct cpu *victim;
+	int curr_pri, top;
+
+	ASSERT(intr_context());
+
+	if (cpu_online_cnt == 1)
+		return;
+
+	victim = find_busiest(self, &top);
+	if (victim == NULL)
+		return;
+	curr_pri = curr == self->idle_thread ? -1 : curr->effective_priority;
+
+	rq_lock_pair(self, victim);
+	if (top > curr_pri)
+		t = migrate_one(self, victim, top);
+	else if (top == curr_pri && (self->ready_bitmap == 0 || highest_bit(self->ready_bitmap) <= top)
+			 && victim->ready_cnt > self->ready_cnt + 1)
+		t = migrate_one(self, victim, top);
+	rq_unlock_pair(self, victim);
+
+	if (t != NULL && t->ready_pri > curr_pri)
+		intr_yield_on_return();
 }
 
 /* Use iretq to launch the thread */
@@ -768,11 +1290,20 @@ thread_launch(struct thread *th)
 {
 	uint64_t tf_cur = (uint64_t)&running_thread()->tf;
 	uint64_t tf = (uint64_t)&th->tf;
+	uint64_t next_sp = (uint64_t)&th->switch_sp;
 	ASSERT(intr_get_level() == INTR_OFF);
 
+	/* 보통은 callee-saved 레지스터와 rsp만 저장하는 switch.S의
+	   짧은 경로를 쓴다.  아래의 전체 저장 경로는 비교용으로만 남겨둔다. */
+	if (!thread_switch_full)
+	{
+		switch_threads(&running_thread()->switch_sp, &th->switch_sp, &th->tf);
+		return;
+	}
+
 	/* The main switching logic.
 	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
+	 * and then switching to the next thread through switch_resume.
 	 * Note that, we SHOULD NOT use any stack from here
 	 * until switching is done.
 	 * 주요 전환 로직입니다.
@@ -820,10 +1351,11 @@ thread_launch(struct thread *th)
 		"mov %%rbx, 16(%%rax)\n" // eflags
 		"mov %%rsp, 24(%%rax)\n" // rsp
 		"movw %%ss, 32(%%rax)\n"
-		"mov %%rcx, %%rdi\n"
-		"call do_iret\n"
+		"mov %%rcx, %%rsi\n"
+		"movq %2, %%rdi\n"
+		"call switch_resume\n"
 		"out_iret:\n"
-		: : "g"(tf_cur), "g"(tf) : "memory");
+		: : "g"(tf_cur), "g"(tf), "g"(next_sp) : "memory");
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -854,15 +1386,20 @@ schedule(void)
 	ASSERT(intr_get_level() == INTR_OFF);
 	ASSERT(curr->status != THREAD_RUNNING);
 	ASSERT(is_thread(next));
+	rcu_note_context_switch(curr);
+	if (curr != next)
+		account_switch(curr, next);
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->cpu->running = next;
 
 	/* Start new time slice. */
-	thread_ticks = 0;
+	next->cpu->thread_ticks = 0;
 
 #ifdef USERPROG
 	/* Activate the new address space. */
 	process_activate(next);
+	fpu_switch(next);
 #endif
 
 	if (curr != next)
@@ -890,6 +1427,165 @@ schedule(void)
 		 * of current running. */
 		thread_launch(next);
 	}
+
+	/* 우리로 전환한 쓰레드의 문맥 저장이 끝났으므로 (또는 전환이
+	   없었으므로) 이제 다른 CPU가 그 쓰레드를 가져가도 된다. */
+	cpu_current()->switching = NULL;
+}
+
+/* Deadline scheduling.
+
+   A thread in the deadline class is given DL_RUNTIME ticks of CPU
+   time in every period of DL_PERIOD ticks, to be used within
+   DL_DEADLINE ticks of the start of the period.  Such threads are
+   run earliest deadline first, ahead of all other threads, as
+   long as they have budget left in the current period.  A thread
+   that uses up its budget is throttled: it is scheduled like any
+   other thread, at its priority, until dl_timer refills its
+   budget at the start of the next period.  A thread that sleeps
+   gets a full budget again if it wakes in a later period.
+
+   thread_set_deadline() admits a thread only if the total
+   runtime/period of all deadline threads stays within
+   DL_BW_MAX, so every admitted thread meets its deadlines as
+   long as DEADLINE equals PERIOD.
+
+   Priority donation is not deadline-aware: a deadline thread
+   waiting on a lock donates only its priority. */
+
+/* T의 주기가 지났으면 NOW가 들어있는 주기로 옮기고 예산을 채운다. */
+static void
+dl_refresh(struct thread *t, int64_t now)
+{
+	if (now >= t->dl_start + t->dl_period)
+	{
+		t->dl_start += (now - t->dl_start) / t->dl_period * t->dl_period;
+		t->dl_budget = t->dl_runtime;
+	}
+}
+
+/* 실행 중인 마감 쓰레드 T에게 한 틱을 청구한다 (thread_tick에서).
+   예산을 다 쓰면 다음 주기까지 일반 쓰레드로 내린다. */
+static void
+dl_charge(struct thread *t)
+{
+	dl_refresh(t, timer_ticks());
+	if (--t->dl_budget > 0)
+		return;
+	timeout_add(&t->dl_timer, t->dl_start + t->dl_period);
+	intr_yield_on_return();
+}
+
+/* dl_list에 막 들어간 T가 T의 CPU에서 실행 중인 쓰레드보다 급한가. */
+static bool
+dl_preempts(struct thread *t)
+{
+	struct thread *curr = thread_current();
+
+	if (t->cpu != curr->cpu)
+		return false;
+	if (curr->dl_runtime == 0 || curr->dl_budget == 0)
+		return true;
+	return t->dl_start + t->dl_deadline < curr->dl_start + curr->dl_deadline;
+}
+
+/* dl_timer 콜백.  다음 주기가 시작됐으니 예산을 채우고, 실행 큐에서
+   기다리고 있었다면 dl_list로 옮긴다. */
+static void
+dl_replenish(void *t_)
+{
+	struct thread *t = t_;
+
+	dl_refresh(t, timer_ticks());
+	if (t->status == THREAD_READY && !t->dl_queued && t->dl_budget > 0)
+	{
+		thread_relocate_ready(t);
+		if (dl_preempts(t))
+			intr_yield_on_return();
+	}
+}
+
+/* 실행 중인 T를 마감 클래스에서 뺀다.  인터럽트를 끄고 호출. */
+static void
+dl_leave(struct thread *t)
+{
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	if (t->dl_runtime == 0)
+		return;
+	timeout_cancel(&t->dl_timer);
+	dl_bw -= t->dl_runtime * DL_BW_ONE / t->dl_period;
+	t->dl_runtime = t->dl_budget = 0;
+}
+
+/* Puts the running thread in the deadline class, to receive
+   RUNTIME timer ticks within DEADLINE ticks of the start of every
+   PERIOD ticks, starting now.  RUNTIME of 0 returns it to the
+   normal classes.  Returns false, leaving the thread as it was,
+   if the parameters are not 0 < RUNTIME <= DEADLINE <= PERIOD or
+   if admitting the thread would overcommit the CPU. */
+bool thread_set_deadline(int64_t runtime, int64_t deadline, int64_t period)
+{
+	struct thread *curr = thread_current();
+	enum intr_level old_level;
+	int64_t bw = 0, old_bw = 0;
+
+	ASSERT(!intr_context());
+
+	if (runtime < 0 || (runtime > 0 && (runtime > deadline || deadline > period)))
+		return false;
+	if (runtime > 0)
+		bw = runtime * DL_BW_ONE / period;
+
+	old_level = intr_disable();
+	if (curr->dl_runtime > 0)
+		old_bw = curr->dl_runtime * DL_BW_ONE / curr->dl_period;
+	if (dl_bw - old_bw + bw > DL_BW_MAX)
+	{
+		intr_set_level(old_level);
+		return false;
+	}
+	dl_leave(curr);
+	if (runtime > 0)
+	{
+		curr->dl_runtime = curr->dl_budget = runtime;
+		curr->dl_deadline = deadline;
+		curr->dl_period = period;
+		curr->dl_start = timer_ticks();
+		dl_bw += bw;
+	}
+	intr_set_level(old_level);
+
+	/* 클래스가 바뀌었으니 다시 고르게 한다. */
+	thread_yield();
+	return true;
+}
+
+/* schedule()에서 CURR가 NEXT에게 CPU를 넘기는 순간의 통계.
+   CURR가 READY면 밀려난 것이고, BLOCKED나 DYING이면 스스로 내놓은 것이다.
+   idle 쓰레드는 실행 큐에서 기다리지 않으므로 대기 시간을 세지 않는다. */
+static void
+account_switch(struct thread *curr, struct thread *next)
+{
+	int64_t now = timer_ns();
+
+	curr->stats.run_ns += now - curr->stats_stamp;
+	if (curr->status == THREAD_READY)
+		curr->stats.involuntary++;
+	else
+		curr->stats.voluntary++;
+	curr->stats_stamp = now;
+
+	if (next != next->cpu->idle_thread)
+	{
+		int64_t wait = now - next->stats_stamp;
+
+		next->stats.ready_ns += wait;
+		if (wait > next->stats.ready_max_ns)
+			next->stats.ready_max_ns = wait;
+	}
+	next->stats.dispatches++;
+	next->stats_stamp = now;
 }
 
 /* Returns a tid to use for a new thread. */
@@ -906,26 +1602,10 @@ allocate_tid(void)
 	return tid;
 }
 
-/* recent_cpu 비교 */
-bool cmp_recent(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
-{
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
-	return (a->recent_cpu < b->recent_cpu);
-}
-
-/*삽입 정렬 시 wake_tick 비교 함수*/
-bool cmp_wake_tick(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
-{
-	const struct thread *a = list_entry(a_, struct thread, elem);
-	const struct thread *b = list_entry(b_, struct thread, elem);
-	return (a->wake_tick < b->wake_tick);
-}
-
 /* 우선순위 비교 */
 bool cmp_priority(const struct list_elem *a_, const struct list_elem *b_, void *aux UNUSED)
 {
 	const struct thread *a = list_entry(a_, struct thread, elem);
 	const struct thread *b = list_entry(b_, struct thread, elem);
-	return (thread_get_priority_manual(a) > thread_get_priority_manual(b));
+	return a->effective_priority > b->effective_priority;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
 #include <stdio.h>
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -10,6 +11,7 @@
 static long long page_fault_cnt;
 
 static void kill (struct intr_frame *);
+static void device_not_available (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
@@ -45,7 +47,7 @@ exception_init (void) {
 	intr_register_int (0, 0, INTR_ON, kill, "#DE Divide Error");
 	intr_register_int (1, 0, INTR_ON, kill, "#DB Debug Exception");
 	intr_register_int (6, 0, INTR_ON, kill, "#UD Invalid Opcode Exception");
-	intr_register_int (7, 0, INTR_ON, kill,
+	intr_register_int (7, 0, INTR_ON, device_not_available,
 			"#NM Device Not Available Exception");
 	intr_register_int (11, 0, INTR_ON, kill, "#NP Segment Not Present");
 	intr_register_int (12, 0, INTR_ON, kill, "#SS Stack Fault Exception");
@@ -105,6 +107,18 @@ kill (struct intr_frame *f) {
 	}
 }
 
+/* #NM handler.  schedule() sets CR0.TS whenever it switches to a
+   thread whose FPU state is not in the registers, so the first
+   FPU or SSE instruction the thread executes afterward lands
+   here.  fpu_trap() swaps the state in and the instruction is
+   restarted; if it cannot, the exception is treated like any
+   other. */
+static void
+device_not_available (struct intr_frame *f) {
+	if (!fpu_trap ())
+		kill (f);
+}
+
 /* Page fault handler.  This is a skeleton that must be filled in
    to implement virtual memory.  Some solutions to project 2 may
    also require modifying this code.
@@ -0,0 +1,193 @@
+#include "userprog/fpu.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/cpu.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "intrinsic.h"
+
+/* Lazy FPU/SSE context switching.
+
+   The kernel itself is compiled without SSE, so only user
+   programs (and explicit inline assembly) touch the x87 and SSE
+   registers.  Saving and restoring them on every switch would
+   cost every thread a few hundred bytes of memory traffic, so
+   instead the CPU remembers which thread's state its registers
+   hold, in fpu_owner, and schedule() sets CR0.TS whenever it
+   switches to any other thread.  The first FPU or SSE
+   instruction such a thread executes raises #NM, and fpu_trap()
+   saves the owner's registers, loads the current thread's, and
+   clears CR0.TS.  A thread that never uses the FPU never pays
+   for it, and one that runs alone does not trap at all.
+
+   The saved state lives in a page allocated on first use, which
+   is enough for the XSAVE area of x87, SSE and AVX.  XSAVE is
+   used if the CPU supports it, FXSAVE otherwise.
+
+   This assumes that a thread whose state is in a CPU's registers
+   is next run on the same CPU.  Only user threads use the FPU,
+   and they never leave cpu0 (see thread_create_bound()). */
+
+/* CR0 and CR4 bits. */
+#define CR0_MP (1 << 1)           /* Monitor coprocessor. */
+#define CR0_EM (1 << 2)           /* Emulation. */
+#define CR0_TS (1 << 3)           /* Task switched. */
+#define CR0_NE (1 << 5)           /* Native FPU error reporting. */
+#define CR4_OSFXSR (1 << 9)       /* FXSAVE/FXRSTOR and SSE. */
+#define CR4_OSXMMEXCPT (1 << 10)  /* Unmasked SSE exceptions raise #XF. */
+#define CR4_OSXSAVE (1 << 18)     /* XSAVE and XCR0. */
+
+/* CPUID.1 feature bits. */
+#define CPUID_EDX_FXSR (1 << 24)
+#define CPUID_EDX_SSE (1 << 25)
+#define CPUID_ECX_XSAVE (1 << 26)
+
+/* XCR0 state components that we save. */
+#define XCR0_X87 (1 << 0)
+#define XCR0_SSE (1 << 1)
+#define XCR0_AVX (1 << 2)
+
+/* Initial FCW and MXCSR: all exceptions masked, round to nearest. */
+#define FCW_INIT 0x037f
+#define MXCSR_INIT 0x1f80
+
+static bool fpu_enabled;        /* Set once the FPU is usable. */
+static bool use_xsave;          /* XSAVE rather than FXSAVE. */
+static uint64_t xsave_mask;     /* Value written to XCR0. */
+
+static void
+stts (void) {
+	lcr0 (rcr0 () | CR0_TS);
+}
+
+static void
+xsetbv (uint32_t reg, uint64_t val) {
+	__asm __volatile ("xsetbv"
+			: : "c" (reg), "a" ((uint32_t) val), "d" ((uint32_t) (val >> 32)));
+}
+
+/* Saves the FPU registers into AREA. */
+static void
+fpu_save (void *area) {
+	if (use_xsave)
+		__asm __volatile ("xsave64 (%0)"
+				: : "r" (area), "a" ((uint32_t) xsave_mask),
+				  "d" ((uint32_t) (xsave_mask >> 32)) : "memory");
+	else
+		__asm __volatile ("fxsave64 (%0)" : : "r" (area) : "memory");
+}
+
+/* Loads the FPU registers from AREA. */
+static void
+fpu_restore (void *area) {
+	if (use_xsave)
+		__asm __volatile ("xrstor64 (%0)"
+				: : "r" (area), "a" ((uint32_t) xsave_mask),
+				  "d" ((uint32_t) (xsave_mask >> 32)) : "memory");
+	else
+		__asm __volatile ("fxrstor64 (%0)" : : "r" (area) : "memory");
+}
+
+/* Enables the FPU and SSE on the running CPU, with CR0.TS set so
+   that the first use traps.  Leaves the FPU disabled, so that any
+   use is fatal, if the CPU lacks FXSAVE or SSE. */
+void
+fpu_init (void) {
+	uint32_t eax, ebx, ecx, edx;
+	uint64_t cr4;
+
+	cpuid (1, 0, &eax, &ebx, &ecx, &edx);
+	if (!(edx & CPUID_EDX_FXSR) || !(edx & CPUID_EDX_SSE))
+		return;
+
+	cr4 = rcr4 () | CR4_OSFXSR | CR4_OSXMMEXCPT;
+	if (ecx & CPUID_ECX_XSAVE) {
+		cpuid (0xd, 0, &eax, &ebx, &ecx, &edx);
+		xsave_mask = eax & (XCR0_X87 | XCR0_SSE | XCR0_AVX);
+		lcr4 (cr4 | CR4_OSXSAVE);
+		xsetbv (0, xsave_mask);
+
+		/* EBX is the size of the area for the components now
+		   enabled in XCR0. */
+		cpuid (0xd, 0, &eax, &ebx, &ecx, &edx);
+		ASSERT (ebx <= PGSIZE);
+		use_xsave = true;
+	} else
+		lcr4 (cr4);
+
+	lcr0 ((rcr0 () & ~CR0_EM) | CR0_MP | CR0_NE | CR0_TS);
+	fpu_enabled = true;
+}
+
+/* Called by schedule() with interrupts off, before switching to
+   NEXT.  Lets NEXT use the FPU without a trap only if its state
+   is already in the registers. */
+void
+fpu_switch (struct thread *next) {
+	if (!fpu_enabled)
+		return;
+	if (next->cpu->fpu_owner == next)
+		clts ();
+	else
+		stts ();
+}
+
+/* Handles #NM for the running thread: gives it the FPU, loading
+   its state, or the initial state on first use.  Returns false if
+   the FPU is not enabled or no page is left for the state. */
+bool
+fpu_trap (void) {
+	struct thread *t = thread_current ();
+	enum intr_level old_level;
+	struct cpu *c;
+
+	if (!fpu_enabled)
+		return false;
+
+	if (t->fpu == NULL) {
+		uint8_t *area = palloc_get_page (PAL_ZERO);
+		if (area == NULL)
+			return false;
+		/* A zeroed XSAVE header selects the initial state of every
+		   component; FXRSTOR reads the legacy area only. */
+		*(uint16_t *) (area + 0) = FCW_INIT;
+		*(uint32_t *) (area + 24) = MXCSR_INIT;
+		t->fpu = area;
+	}
+
+	/* 여기서 선점되면 TS가 다시 켜지므로, 인터럽트를 끄고 진행한다. */
+	old_level = intr_disable ();
+	c = t->cpu;
+	clts ();
+	if (c->fpu_owner != t) {
+		if (c->fpu_owner != NULL)
+			fpu_save (c->fpu_owner->fpu);
+		fpu_restore (t->fpu);
+		c->fpu_owner = t;
+	}
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Frees T's saved FPU state.  Called by thread_exit(), and by
+   process_exec() so that a new program starts from the initial
+   state.  If T is running with the FPU, sets CR0.TS so that its
+   next use traps and loads that state. */
+void
+fpu_release (struct thread *t) {
+	enum intr_level old_level;
+	void *area;
+
+	old_level = intr_disable ();
+	if (t->cpu->fpu_owner == t) {
+		t->cpu->fpu_owner = NULL;
+		if (t == thread_current () && fpu_enabled)
+			stts ();
+	}
+	area = t->fpu;
+	t->fpu = NULL;
+	intr_set_level (old_level);
+
+	palloc_free_page (area);
+}
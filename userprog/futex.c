@@ -0,0 +1,187 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+
+/* Futexes ("fast user-space mutexes").
+
+   A user program keeps its lock (or other synchronization state)
+   in an ordinary int in its own memory, and only enters the
+   kernel to sleep when it has to wait, with futex_wait(), or to
+   wake sleepers, with futex_wake().  The kernel keeps no state
+   for a futex except the threads waiting on it.
+
+   Waiters are keyed by the physical address of the int, not its
+   user virtual address, so processes that share the page (for
+   example, after fork() with shared memory) share the futex.
+   They are hashed into FUTEX_BUCKETS lists, protected by
+   disabling interrupts like the rest of the kernel's wait
+   queues. */
+
+#define FUTEX_BUCKETS 64
+
+/* A thread sleeping in futex_wait(). */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in a bucket. */
+	uint64_t key;               /* Physical address waited on. */
+	struct thread *leader;      /* Process of the waiter. */
+	struct semaphore sema;      /* Upped by futex_wake(). */
+};
+
+static struct list buckets[FUTEX_BUCKETS];
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	int i;
+
+	for (i = 0; i < FUTEX_BUCKETS; i++)
+		list_init (&buckets[i]);
+}
+
+/* Returns the kernel address of the int at user address UADDR in
+   the current process, or NULL if UADDR is not a valid, aligned,
+   mapped user address. */
+static int *
+futex_kaddr (int *uaddr) {
+	struct thread *t = thread_current ();
+	void *kaddr;
+
+	if (uaddr == NULL || !is_user_vaddr (uaddr) || (uint64_t) uaddr % sizeof (int) != 0)
+		return NULL;
+	kaddr = pml4_get_page (t->pml4, uaddr);
+#ifdef VM
+	/* 아직 올라오지 않은 페이지면 지금 올린다. */
+	if (kaddr == NULL && vm_claim_page (pg_round_down (uaddr)))
+		kaddr = pml4_get_page (t->pml4, uaddr);
+#endif
+	return kaddr;
+}
+
+/* KEY가 들어가는 bucket. */
+static struct list *
+futex_bucket (uint64_t key) {
+	return &buckets[(key >> 2) % FUTEX_BUCKETS];
+}
+
+/* If the int at UADDR still equals EXPECTED, sleeps until another
+   thread calls futex_wake() on it or, if TIMEOUT_MS is not
+   negative, until that many milliseconds have passed.  Returns 0
+   if woken, -1 if the value differed, the wait timed out, the
+   process is exiting, or UADDR is invalid.
+
+   The check and the start of the wait are atomic with respect to
+   futex_wake(), so a wake that follows a change to *UADDR is
+   never lost. */
+int
+futex_wait (int *uaddr, int expected, int timeout_ms) {
+	struct futex_waiter w;
+	enum intr_level old_level;
+	int *kaddr = futex_kaddr (uaddr);
+	bool woken;
+
+	if (kaddr == NULL)
+		return -1;
+
+	w.key = vtop (kaddr);
+	w.leader = thread_current ()->leader;
+	sema_init (&w.sema, 0);
+
+	old_level = intr_disable ();
+	if (*(volatile int *) kaddr != expected || w.leader->exiting) {
+		intr_set_level (old_level);
+		return -1;
+	}
+	list_push_back (futex_bucket (w.key), &w.elem);
+	intr_set_level (old_level);
+
+	if (timeout_ms < 0) {
+		sema_down (&w.sema);
+		return 0;
+	}
+
+	woken = sema_down_timeout (&w.sema,
+			DIV_ROUND_UP ((int64_t) timeout_ms * TIMER_FREQ, 1000));
+	if (!woken) {
+		/* futex_wake()가 타임아웃 직후에 깨웠을 수도 있다. */
+		old_level = intr_disable ();
+		if (sema_try_down (&w.sema))
+			woken = true;
+		else
+			list_remove (&w.elem);
+		intr_set_level (old_level);
+	}
+	return woken ? 0 : -1;
+}
+
+/* Wakes up to N threads waiting on the int at UADDR, oldest
+   first.  Returns the number of threads woken, or -1 if UADDR is
+   invalid. */
+int
+futex_wake (int *uaddr, int n) {
+	struct list *bucket;
+	struct list_elem *e;
+	enum intr_level old_level;
+	int *kaddr = futex_kaddr (uaddr);
+	uint64_t key;
+	int cnt = 0;
+
+	if (kaddr == NULL)
+		return -1;
+
+	key = vtop (kaddr);
+	bucket = futex_bucket (key);
+	old_level = intr_disable ();
+	for (e = list_begin (bucket); e != list_end (bucket) && cnt < n;) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		if (w->key != key) {
+			e = list_next (e);
+			continue;
+		}
+		e = list_remove (e);
+		sema_up (&w->sema);
+		cnt++;
+	}
+	intr_set_level (old_level);
+	return cnt;
+}
+
+/* Wakes every thread of the process led by LEADER that is waiting
+   on a futex.  Called when the process exits, after it has set
+   LEADER->exiting, so that no thread of it sleeps here for good. */
+void
+futex_wake_process (struct thread *leader) {
+	enum intr_level old_level;
+	int i;
+
+	old_level = intr_disable ();
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		struct list *bucket = &buckets[i];
+		struct list_elem *e;
+
+		for (e = list_begin (bucket); e != list_end (bucket);) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			if (w->leader != leader) {
+				e = list_next (e);
+				continue;
+			}
+			list_remove (e);
+			sema_up (&w->sema);
+			/* sema_up()이 양보하는 동안 bucket이 바뀌었을 수 있다. */
+			e = list_begin (bucket);
+		}
+	}
+	intr_set_level (old_level);
+}
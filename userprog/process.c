@@ -5,14 +5,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "userprog/futex.h"
+#include "userprog/fpu.h"
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "threads/cpu.h"
 #include "threads/flags.h"
 #include "threads/init.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
@@ -26,6 +30,9 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void uthread_exit (void);
+static void uthread_reap_all (void);
+static void uthread_stack_free (int slot);
 
 /* General process initializer for initd and other process. */
 static void
@@ -51,7 +58,7 @@ process_create_initd (const char *file_name) {
 	strlcpy (fn_copy, file_name, PGSIZE);
 
 	/* Create a new thread to execute FILE_NAME. */
-	tid = thread_create (file_name, PRI_DEFAULT, initd, fn_copy);
+	tid = thread_create_bound (file_name, PRI_DEFAULT, initd, fn_copy);
 	if (tid == TID_ERROR)
 		palloc_free_page (fn_copy);
 	return tid;
@@ -76,7 +83,7 @@ initd (void *f_name) {
 tid_t
 process_fork (const char *name, struct intr_frame *if_ UNUSED) {
 	/* Clone current thread to new thread.*/
-	return thread_create (name,
+	return thread_create_bound (name,
 			PRI_DEFAULT, __do_fork, thread_current ());
 }
 
@@ -159,7 +166,8 @@ error:
 }
 
 /* Switch the current execution context to the f_name.
- * Returns -1 on fail. */
+ * Returns -1 on fail, or if the caller is not the main thread of
+ * its process. */
 int
 process_exec (void *f_name) {
 	char *file_name = f_name;
@@ -173,8 +181,15 @@ process_exec (void *f_name) {
 	_if.cs = SEL_UCSEG;
 	_if.eflags = FLAG_IF | FLAG_MBS;
 
+	/* Only the leader owns the address space that it replaces. */
+	if (thread_current ()->uthread != NULL) {
+		palloc_free_page (file_name);
+		return -1;
+	}
+
 	/* We first kill the current context */
 	process_cleanup ();
+	fpu_release (thread_current ());
 
 	/* And then load the binary */
 	success = load (file_name, &_if);
@@ -216,6 +231,11 @@ process_exit (void) {
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
+	/* 사용자 쓰레드는 주소 공간을 메인 쓰레드에 남겨두고 떠난다. */
+	if (curr->uthread != NULL) {
+		uthread_exit ();
+		return;
+	}
 	process_cleanup ();
 }
 
@@ -224,6 +244,9 @@ static void
 process_cleanup (void) {
 	struct thread *curr = thread_current ();
 
+	/* Other threads may still be running in this address space. */
+	uthread_reap_all ();
+
 #ifdef VM
 	supplemental_page_table_kill (&curr->spt);
 #endif
@@ -253,8 +276,10 @@ process_activate (struct thread *next) {
 	/* Activate thread's page tables. */
 	pml4_activate (next->pml4);
 
-	/* Set thread's kernel stack for use in processing interrupts. */
-	tss_update (next);
+	/* Set thread's kernel stack for use in processing interrupts.
+	   The TSS is cpu0's, the only CPU that runs user code. */
+	if (next->cpu == &cpus[0])
+		tss_update (next);
 }
 
 /* We load ELF binaries.  The following definitions are taken
@@ -637,3 +662,303 @@ setup_stack (struct intr_frame *if_) {
 	return success;
 }
 #endif /* VM */
+
+/* User threads.
+
+   A process may run several threads in the address space of its
+   main thread, the "leader".  Each user thread gets its own user
+   stack in a slot below the main thread's stack, and is started
+   at ENTRY (FN, ARG), where ENTRY is a trampoline in the user
+   library that calls FN and passes its return value to the
+   thread_exit system call.
+
+   The leader owns the page table (and, with VM, the supplemental
+   page table), so it outlives the other threads: when it exits
+   or execs, it sets its `exiting' flag, wakes the threads that
+   sleep on a futex, and waits for all of them to exit.  Every
+   other thread exits on its next way back to user mode, from a
+   system call or an interrupt, once it sees the flag. */
+
+#define UTHREAD_MAX 64                          /* Slots in uthread_slots. */
+#define UTHREAD_STACK_SIZE (64 * 1024)          /* Address space per slot. */
+#define UTHREAD_STACK_TOP (USER_STACK - (1 << 20)) /* Below the main stack. */
+
+/* Pages of stack per slot.  The lowest page of a slot is left
+   unmapped, so that a stack overflow faults instead of running
+   into the next slot. */
+#define UTHREAD_STACK_PAGES (UTHREAD_STACK_SIZE / PGSIZE - 1)
+
+/* A user thread, as seen by process_thread_join().  Allocated by
+   the creator and freed by whoever joins or reaps it, so it
+   outlives the thread itself. */
+struct uthread {
+	struct list_elem elem;      /* In leader->uthreads until joined. */
+	struct thread *leader;      /* Owner of the address space. */
+	tid_t tid;                  /* Thread id. */
+	int slot;                   /* Stack slot. */
+	void *entry, *fn, *arg;     /* Started as ENTRY (FN, ARG). */
+	uint64_t retval;            /* Passed to process_thread_exit(). */
+	struct semaphore dead;      /* Upped when the thread has exited. */
+};
+
+/* Returns the user address of the top of stack slot SLOT. */
+static uint8_t *
+uthread_stack_top (int slot) {
+	return (uint8_t *) UTHREAD_STACK_TOP - (uint64_t) slot * UTHREAD_STACK_SIZE;
+}
+
+/* Maps UTHREAD_STACK_PAGES zeroed pages at the top of stack slot
+   SLOT in the current address space.  With VM only the top page
+   is claimed now; the others are filled in when first touched. */
+static bool
+uthread_stack_alloc (int slot) {
+	uint8_t *top = uthread_stack_top (slot);
+	int i;
+
+	for (i = 1; i <= UTHREAD_STACK_PAGES; i++) {
+		void *upage = top - i * PGSIZE;
+#ifdef VM
+		if (!vm_alloc_page (VM_ANON | VM_MARKER_0, upage, true)
+				|| (i == 1 && !vm_claim_page (upage)))
+			goto fail;
+#else
+		uint8_t *kpage = palloc_get_page (PAL_USER | PAL_ZERO);
+
+		if (kpage == NULL)
+			goto fail;
+		if (!install_page (upage, kpage, true)) {
+			palloc_free_page (kpage);
+			goto fail;
+		}
+#endif
+	}
+	return true;
+
+fail:
+	uthread_stack_free (slot);
+	return false;
+}
+
+/* Unmaps the stack of slot SLOT in the current address space. */
+static void
+uthread_stack_free (int slot) {
+	uint8_t *top = uthread_stack_top (slot);
+	struct thread *curr = thread_current ();
+	int i;
+
+	for (i = 1; i <= UTHREAD_STACK_PAGES; i++) {
+		void *upage = top - i * PGSIZE;
+#ifdef VM
+		struct page *page = spt_find_page (&curr->leader->spt, upage);
+
+		if (page != NULL)
+			spt_remove_page (&curr->leader->spt, page);
+#else
+		void *kpage = pml4_get_page (curr->pml4, upage);
+
+		if (kpage != NULL) {
+			pml4_clear_page (curr->pml4, upage);
+			palloc_free_page (kpage);
+		}
+#endif
+	}
+}
+
+/* Releases UT's stack slot and frees it.  UT must have exited. */
+static void
+uthread_free (struct uthread *ut) {
+	enum intr_level old_level = intr_disable ();
+	ut->leader->uthread_slots &= ~(1ULL << ut->slot);
+	intr_set_level (old_level);
+	free (ut);
+}
+
+/* A thread function that enters user mode as a new thread of the
+   process that created it. */
+static void
+uthread_start (void *aux) {
+	struct uthread *ut = aux;
+	struct thread *curr = thread_current ();
+	struct intr_frame if_;
+
+	curr->leader = ut->leader;
+	curr->uthread = ut;
+	curr->pml4 = ut->leader->pml4;
+	process_activate (curr);
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	if_.rip = (uint64_t) ut->entry;
+	if_.R.rdi = (uint64_t) ut->fn;
+	if_.R.rsi = (uint64_t) ut->arg;
+	/* As if ENTRY had just been called. */
+	if_.rsp = (uint64_t) uthread_stack_top (ut->slot) - sizeof (void *);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* Starts a new thread in the current process, running
+   ENTRY (FN, ARG) in user mode on a stack of its own.  Returns
+   the new thread's id, or TID_ERROR if it cannot be created. */
+tid_t
+process_thread_create (void *entry, void *fn, void *arg) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	struct uthread *ut;
+	enum intr_level old_level;
+	int slot;
+
+	if (!is_user_vaddr (entry))
+		return TID_ERROR;
+	ut = malloc (sizeof *ut);
+	if (ut == NULL)
+		return TID_ERROR;
+
+	/* 빈 스택 슬롯을 잡는다.  프로세스가 끝나는 중이면 만들지 않는다. */
+	old_level = intr_disable ();
+	slot = leader->exiting ? UTHREAD_MAX : 0;
+	for (; slot < UTHREAD_MAX; slot++)
+		if (!(leader->uthread_slots & (1ULL << slot)))
+			break;
+	if (slot < UTHREAD_MAX)
+		leader->uthread_slots |= 1ULL << slot;
+	intr_set_level (old_level);
+	if (slot == UTHREAD_MAX) {
+		free (ut);
+		return TID_ERROR;
+	}
+
+	ut->leader = leader;
+	ut->slot = slot;
+	ut->entry = entry;
+	ut->fn = fn;
+	ut->arg = arg;
+	ut->retval = (uint64_t) -1;
+	sema_init (&ut->dead, 0);
+	if (!uthread_stack_alloc (slot)) {
+		uthread_free (ut);
+		return TID_ERROR;
+	}
+
+	/* The new thread may run (and exit) before thread_create()
+	   returns, so it must already be on the list. */
+	old_level = intr_disable ();
+	list_push_back (&leader->uthreads, &ut->elem);
+	intr_set_level (old_level);
+
+	ut->tid = thread_create_bound (curr->name, thread_get_priority (),
+			uthread_start, ut);
+	if (ut->tid == TID_ERROR) {
+		old_level = intr_disable ();
+		list_remove (&ut->elem);
+		intr_set_level (old_level);
+		uthread_stack_free (slot);
+		uthread_free (ut);
+	}
+	return ut->tid;
+}
+
+/* Waits for thread TID of the current process to exit and stores
+   the value it passed to process_thread_exit() in *RETVAL.
+   Returns 0 on success, or -1 if TID is not a joinable thread of
+   this process.  Each thread can be joined only once. */
+int
+process_thread_join (tid_t tid, uint64_t *retval) {
+	struct thread *curr = thread_current ();
+	struct list *uthreads = &curr->leader->uthreads;
+	struct uthread *ut = NULL;
+	enum intr_level old_level;
+	struct list_elem *e;
+
+	if (tid == curr->tid)
+		return -1;
+
+	old_level = intr_disable ();
+	for (e = list_begin (uthreads); e != list_end (uthreads); e = list_next (e))
+		if (list_entry (e, struct uthread, elem)->tid == tid) {
+			ut = list_entry (e, struct uthread, elem);
+			list_remove (&ut->elem);
+			break;
+		}
+	intr_set_level (old_level);
+	if (ut == NULL)
+		return -1;
+
+	sema_down (&ut->dead);
+	*retval = ut->retval;
+	uthread_free (ut);
+	return 0;
+}
+
+/* Exits the current thread with RETVAL as the value for
+   process_thread_join().  In the main thread this exits the
+   process, after all the other threads have exited. */
+void
+process_thread_exit (uint64_t retval) {
+	struct thread *curr = thread_current ();
+
+	if (curr->uthread != NULL)
+		curr->uthread->retval = retval;
+	thread_exit ();
+}
+
+/* Exits the current thread if it is not the leader and its
+   process is exiting.  Called on the way back to user mode. */
+void
+process_check_exit (void) {
+	struct thread *curr = thread_current ();
+
+	if (curr->uthread != NULL && curr->leader->exiting)
+		thread_exit ();
+}
+
+/* Called by process_exit() in a user thread.  Gives up the stack
+   and the shared page table and wakes the joiner. */
+static void
+uthread_exit (void) {
+	struct thread *curr = thread_current ();
+	struct uthread *ut = curr->uthread;
+
+	uthread_stack_free (ut->slot);
+
+	/* The page table belongs to the leader. */
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+	curr->uthread = NULL;
+	sema_up (&ut->dead);
+}
+
+/* Makes every other thread of the current process, which must
+   be the leader (process_exec() refuses the others), exit, waits
+   for the unjoined ones, and frees them. */
+static void
+uthread_reap_all (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (curr->uthread == NULL);
+
+	old_level = intr_disable ();
+	curr->exiting = true;
+	intr_set_level (old_level);
+	futex_wake_process (curr);
+
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct uthread *ut = NULL;
+
+		if (!list_empty (&curr->uthreads))
+			ut = list_entry (list_pop_front (&curr->uthreads), struct uthread, elem);
+		intr_set_level (old_level);
+		if (ut == NULL)
+			break;
+
+		sema_down (&ut->dead);
+		uthread_free (ut);
+	}
+
+	/* 이어서 exec하는 경우 새 프로그램은 다시 쓰레드를 만들 수 있다. */
+	curr->exiting = false;
+}
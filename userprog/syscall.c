@@ -6,6 +6,10 @@
 #include "threads/loader.h"
 #include "userprog/gdt.h"
 #include "threads/flags.h"
+#include "threads/mmu.h"
+#include "threads/vaddr.h"
+#include "userprog/futex.h"
+#include "userprog/process.h"
 #include "intrinsic.h"
 
 void syscall_entry (void);
@@ -35,12 +39,78 @@ syscall_init (void) {
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK,
 			FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
+
+	futex_init ();
+}
+
+/* Returns true if the SIZE bytes at user address UADDR are
+   mapped in the current process. */
+static bool
+user_mapped (const void *uaddr, size_t size) {
+	const uint8_t *p = uaddr;
+	uint64_t *pml4 = thread_current ()->pml4;
+
+	return p != NULL && is_user_vaddr (p + size - 1) && p + size > p
+		&& pml4_get_page (pml4, p) != NULL
+		&& pml4_get_page (pml4, p + size - 1) != NULL;
+}
+
+/* thread_join: RETVAL은 NULL이어도 된다. */
+static int
+sys_thread_join (tid_t tid, void **retval) {
+	uint64_t value;
+
+	if (retval != NULL && !user_mapped (retval, sizeof *retval))
+		return -1;
+	if (process_thread_join (tid, &value) < 0)
+		return -1;
+	if (retval != NULL)
+		*retval = (void *) value;
+	return 0;
+}
+
+/* thread_stats: 통계를 커널에서 읽어 사용자 버퍼로 복사한다. */
+static bool
+sys_thread_stats (tid_t tid, struct thread_stats *ustats) {
+	struct thread_stats stats;
+
+	if (!user_mapped (ustats, sizeof *ustats))
+		return false;
+	if (!thread_get_stats (tid, &stats))
+		return false;
+	*ustats = stats;
+	return true;
 }
 
 /* The main system call interface */
 void
-syscall_handler (struct intr_frame *f UNUSED) {
-	// TODO: Your implementation goes here.
-	printf ("system call!\n");
-	thread_exit ();
+syscall_handler (struct intr_frame *f) {
+	switch (f->R.rax) {
+		case SYS_FUTEX_WAIT:
+			f->R.rax = futex_wait ((int *) f->R.rdi, f->R.rsi, f->R.rdx);
+			break;
+		case SYS_FUTEX_WAKE:
+			f->R.rax = futex_wake ((int *) f->R.rdi, f->R.rsi);
+			break;
+		case SYS_THREAD_CREATE:
+			f->R.rax = process_thread_create ((void *) f->R.rdi,
+					(void *) f->R.rsi, (void *) f->R.rdx);
+			break;
+		case SYS_THREAD_JOIN:
+			f->R.rax = sys_thread_join (f->R.rdi, (void **) f->R.rsi);
+			break;
+		case SYS_THREAD_STATS:
+			f->R.rax = sys_thread_stats (f->R.rdi, (struct thread_stats *) f->R.rsi);
+			break;
+		case SYS_THREAD_EXIT:
+			process_thread_exit (f->R.rdi);
+			NOT_REACHED ();
+		default:
+			// TODO: Your implementation goes here.
+			printf ("system call!\n");
+			thread_exit ();
+	}
+
+	/* 다른 쓰레드가 프로세스를 끝내는 중이면 사용자 모드로 돌아가지 않는다. */
+	process_check_exit ();
 }